@@ -0,0 +1,451 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "analysis.h"
+#include "evaluator.h"
+#include "evalcache.h"
+#include "pgn.h"
+#include "log.h"
+#include "dbgutil.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/************************************************************************/
+
+/* longest time a new eval of the shown ply waits to be drawn */
+#define ANALYSIS_FRAME_MS 50
+
+/* slot index bits, and the flag of a value not taken yet */
+#define ANALYSIS_SLOT_INDEX 3u
+#define ANALYSIS_SLOT_FRESH 4u
+
+/************************************************************************/
+
+typedef struct
+{
+	/* a result is there, possibly from a search still running */
+	bool valid;
+
+	/* the search is over or the cached result is deep enough */
+	bool done;
+
+	EngineSnapshot snapshot;
+} PlyEval;
+
+/* latest eval of the shown ply, handed from the engine threads to the */
+/* main thread */
+typedef struct
+{
+	int ply;
+	EngineSnapshot snapshot;
+} AnalysisSlot;
+
+/* engine of the pool as the scheduler sees it */
+typedef struct
+{
+	/* the engine has the position of this ply */
+	int ply;
+
+	/* ply under search, -1 if the engine is idle */
+	int searching;
+} AnalysisEngine;
+
+/************************************************************************/
+
+static engine_cb_func analysis_show = NULL;
+static int analysis_cache_depth = 0;
+
+static const AnalysisPly* analysis_plies = NULL;
+static int analysis_nb_of_plies = 0;
+
+/* evals by ply, written by the engine threads, guarded by analysis_mutex */
+/* together with analysis_shown */
+static PlyEval* analysis_evals = NULL;
+static int analysis_shown = -1;
+static pthread_mutex_t analysis_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* triple buffer: the writer, holding analysis_mutex, fills the back */
+/* buffer and swaps it with the middle one; the main thread swaps the */
+/* middle one with its front buffer when it is fresh, without waiting */
+/* for the writers */
+static AnalysisSlot analysis_slots[ 3 ];
+static atomic_uint analysis_slot_middle = 1;
+static unsigned analysis_slot_back = 0;
+static unsigned analysis_slot_front = 2;
+
+/* only used by the main thread */
+static AnalysisEngine analysis_engines[ ENGINE_MAX_COUNT ];
+static char analysis_start_fen[ CW_MAX_FEN_STRING ];
+static bool analysis_has_start_fen = false;
+
+/************************************************************************/
+
+static void analysis_collect();
+static void analysis_dispatch( int ply, int time_ms );
+static int analysis_next_ply( int ply );
+static int analysis_pick_engine( int ply );
+static bool analysis_is_searched( int ply );
+static void analysis_start_search( int e, int ply, int time_ms );
+static void analysis_engine_callback( const EngineSnapshot* snapshot, void* ply );
+static void analysis_set_eval( int ply, const EngineSnapshot* snapshot );
+static void analysis_publish( int ply );
+static const AnalysisSlot* analysis_take();
+static void analysis_draw();
+static int analysis_ms_left( const struct timespec* until );
+
+/************************************************************************/
+
+void analysis_init( engine_cb_func show, int cache_depth )
+{
+	analysis_show = show;
+	analysis_cache_depth = cache_depth;
+
+	for ( int e = 0; e < ENGINE_MAX_COUNT; ++e ) {
+		analysis_engines[ e ].ply = 0;
+		analysis_engines[ e ].searching = -1;
+	}
+}
+
+void analysis_start_game( const char* startFEN, const AnalysisPly* plies, int nbofplies )
+{
+	dbgutil_test( plies != NULL );
+	dbgutil_test( nbofplies > 0 );
+
+	analysis_end_game();
+
+	analysis_plies = plies;
+	analysis_nb_of_plies = nbofplies;
+	analysis_evals = calloc( nbofplies, sizeof(PlyEval) );
+	analysis_shown = -1;
+
+	analysis_has_start_fen = ( startFEN != NULL );
+	if ( analysis_has_start_fen ) {
+		snprintf( analysis_start_fen, CW_MAX_FEN_STRING, "%s", startFEN );
+	}
+
+	for ( int e = 0; e < engine_count(); ++e ) {
+		analysis_engines[ e ].ply = 0;
+		analysis_engines[ e ].searching = -1;
+		engine_new_game( e, startFEN );
+	}
+
+	if ( analysis_evals == NULL || !engine_is_available() ) {
+		return;
+	}
+
+	/* earlier showings of the same positions; the cache has the best */
+	/* line only, with more lines wanted the engine runs anyway */
+	uint64_t engine = engine_settings_key();
+	for ( int i = 0; i < nbofplies; ++i ) {
+		if ( !plies[ i ].analyse ) {
+			continue;
+		}
+
+		Position pos;
+		chesspack_unpack( &plies[ i ].pos, &pos );
+
+		EvalCacheEntry cached;
+		if ( evalcache_lookup( &pos, engine, &cached ) ) {
+			EngineSnapshot snapshot;
+			snapshot.depth = cached.depth;
+			snapshot.nbofpvs = 1;
+			snapshot.pvs[ 0 ].type = cached.type;
+			snapshot.pvs[ 0 ].score = cached.score;
+			engine_copy_line( snapshot.pvs[ 0 ].line, cached.line );
+
+			analysis_set_eval( i, &snapshot );
+			analysis_evals[ i ].done = ( cached.depth >= analysis_cache_depth && engine_multipv() == 1 );
+		}
+	}
+}
+
+void analysis_show_ply( int ply, int window_ms, int time_ms )
+{
+	dbgutil_test( ply >= 0 && ply < analysis_nb_of_plies );
+
+	struct timespec until;
+	clock_gettime( CLOCK_MONOTONIC, &until );
+	until.tv_sec += window_ms / 1000;
+	until.tv_nsec += 1000000L * ( window_ms % 1000 );
+	if ( until.tv_nsec >= 1000000000L ) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock( &analysis_mutex );
+	analysis_shown = ply;
+	if ( analysis_evals != NULL && analysis_evals[ ply ].valid ) {
+		analysis_publish( ply );
+	}
+	pthread_mutex_unlock( &analysis_mutex );
+
+	bool engine = engine_is_available();
+
+	if ( analysis_evals != NULL && !engine ) {
+		/* a few ms in process, done before the move is shown */
+		if ( analysis_plies[ ply ].analyse && !analysis_evals[ ply ].valid ) {
+			Position pos;
+			chesspack_unpack( &analysis_plies[ ply ].pos, &pos );
+			evaluator_go( &pos, time_ms,
+					analysis_engine_callback, (void*) &analysis_plies[ ply ] );
+		}
+	}
+
+	/* results are gathered and drawn here, the engine threads only */
+	/* store them */
+	int left = analysis_ms_left( &until );
+	while ( left > 0 ) {
+
+		unsigned done = engine_done_count();
+
+		if ( engine && analysis_evals != NULL ) {
+			analysis_collect();
+			if ( time_ms != 0 ) {
+				analysis_dispatch( ply, time_ms );
+			}
+		}
+
+		analysis_draw();
+
+		engine_wait_done( done, ( left < ANALYSIS_FRAME_MS ) ? left : ANALYSIS_FRAME_MS );
+
+		left = analysis_ms_left( &until );
+	}
+
+	analysis_draw();
+}
+
+void analysis_end_game()
+{
+	for ( int e = 0; e < engine_count(); ++e ) {
+		if ( analysis_engines[ e ].searching >= 0 ) {
+			engine_stop( e );
+			analysis_engines[ e ].searching = -1;
+		}
+	}
+
+	pthread_mutex_lock( &analysis_mutex );
+	free( analysis_evals );
+	analysis_evals = NULL;
+	analysis_shown = -1;
+	pthread_mutex_unlock( &analysis_mutex );
+
+	/* nothing of this game is drawn in the next one, the engines are */
+	/* stopped */
+	(void) analysis_take();
+
+	analysis_plies = NULL;
+	analysis_nb_of_plies = 0;
+}
+
+/************************************************************************/
+
+/* ends the searches that are over; the ply of an engine that died goes */
+/* to another one */
+static void analysis_collect()
+{
+	for ( int e = 0; e < engine_count(); ++e ) {
+		AnalysisEngine* engine = &analysis_engines[ e ];
+
+		if ( engine->searching >= 0 && engine_is_done( e ) ) {
+			if ( engine_is_alive( e ) ) {
+				pthread_mutex_lock( &analysis_mutex );
+				analysis_evals[ engine->searching ].done = true;
+				pthread_mutex_unlock( &analysis_mutex );
+			}
+			engine->searching = -1;
+		}
+	}
+}
+
+/* keeps every idle engine busy, nearest plies first */
+static void analysis_dispatch( int ply, int time_ms )
+{
+	while ( true ) {
+		int next = analysis_next_ply( ply );
+		if ( next < 0 ) {
+			return;
+		}
+
+		int e = analysis_pick_engine( next );
+		if ( e < 0 ) {
+			return;
+		}
+
+		analysis_start_search( e, next, time_ms );
+	}
+}
+
+/* first ply from the shown one on still to be analysed and not searched */
+/* yet, then the plies already shown, their results go to the cache; */
+/* -1 if there is none */
+static int analysis_next_ply( int ply )
+{
+	int next = -1;
+
+	pthread_mutex_lock( &analysis_mutex );
+	for ( int i = 0; i < analysis_nb_of_plies && next < 0; ++i ) {
+		int candidate = ( ply + i ) % analysis_nb_of_plies;
+		if ( analysis_plies[ candidate ].analyse && !analysis_evals[ candidate ].done &&
+			!analysis_is_searched( candidate ) ) {
+			next = candidate;
+		}
+	}
+	pthread_mutex_unlock( &analysis_mutex );
+
+	return next;
+}
+
+/* idle engine with the fewest moves to add to reach ply, one that is past */
+/* ply restarts from the start position; -1 if all engines are busy */
+static int analysis_pick_engine( int ply )
+{
+	int best = -1;
+
+	for ( int e = 0; e < engine_count(); ++e ) {
+		const AnalysisEngine* engine = &analysis_engines[ e ];
+		if ( engine->searching >= 0 || !engine_is_alive( e ) ) {
+			continue;
+		}
+
+		int cost = ( engine->ply <= ply ) ? ply - engine->ply : ply;
+		int bestcost = 0;
+		if ( best >= 0 ) {
+			bestcost = ( analysis_engines[ best ].ply <= ply ) ?
+					ply - analysis_engines[ best ].ply : ply;
+		}
+		if ( best < 0 || cost < bestcost ) {
+			best = e;
+		}
+	}
+
+	return best;
+}
+
+static bool analysis_is_searched( int ply )
+{
+	for ( int e = 0; e < engine_count(); ++e ) {
+		if ( analysis_engines[ e ].searching == ply ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void analysis_start_search( int e, int ply, int time_ms )
+{
+	AnalysisEngine* engine = &analysis_engines[ e ];
+
+	if ( engine->ply > ply ) {
+		engine_set_start_position( e, analysis_has_start_fen ? analysis_start_fen : NULL );
+		engine->ply = 0;
+	}
+
+	while ( engine->ply < ply ) {
+		engine->ply++;
+
+		Position pos;
+		chesspack_unpack( &analysis_plies[ engine->ply ].pos, &pos );
+
+		char fen[ CW_MAX_FEN_STRING ];
+		pgn_position_to_fen( &pos, fen );
+		engine_add_move( e, analysis_plies[ engine->ply ].long_algebraic, fen );
+	}
+
+	LOG( DEBUG, "Analysing ply %d on engine %d", ply, e );
+
+	engine->searching = ply;
+	engine_go( e, time_ms, analysis_engine_callback, (void*) &analysis_plies[ ply ] );
+}
+
+/* engine threads, or the main thread for the built-in evaluator */
+static void analysis_engine_callback( const EngineSnapshot* snapshot, void* ply )
+{
+	const AnalysisPly* p = ply;
+
+	if ( snapshot->nbofpvs < 1 ) {
+		return;
+	}
+
+	pthread_mutex_lock( &analysis_mutex );
+	if ( engine_is_available() ) {
+		/* the engines store one at a time */
+		const EnginePv* best = &snapshot->pvs[ 0 ];
+		Position pos;
+		chesspack_unpack( &p->pos, &pos );
+		evalcache_store( &pos, engine_settings_key(), best->type, best->score,
+				snapshot->depth, best->line );
+	}
+	if ( analysis_evals != NULL ) {
+		/* a deeper cached eval stays until the search gets as deep */
+		int i = (int) ( p - analysis_plies );
+		if ( !analysis_evals[ i ].valid || snapshot->depth >= analysis_evals[ i ].snapshot.depth ) {
+			analysis_set_eval( i, snapshot );
+			if ( i == analysis_shown ) {
+				analysis_publish( i );
+			}
+		}
+	}
+	pthread_mutex_unlock( &analysis_mutex );
+}
+
+/* with analysis_mutex held, or before the engine runs */
+static void analysis_set_eval( int ply, const EngineSnapshot* snapshot )
+{
+	PlyEval* eval = &analysis_evals[ ply ];
+
+	eval->valid = true;
+	eval->snapshot = *snapshot;
+}
+
+/* with analysis_mutex held, one writer at a time */
+static void analysis_publish( int ply )
+{
+	AnalysisSlot* slot = &analysis_slots[ analysis_slot_back ];
+	slot->ply = ply;
+	slot->snapshot = analysis_evals[ ply ].snapshot;
+
+	analysis_slot_back = atomic_exchange_explicit( &analysis_slot_middle,
+			analysis_slot_back | ANALYSIS_SLOT_FRESH, memory_order_acq_rel ) & ANALYSIS_SLOT_INDEX;
+}
+
+/* main thread, the latest value published since the last call, NULL if */
+/* there is none */
+static const AnalysisSlot* analysis_take()
+{
+	if ( ( atomic_load_explicit( &analysis_slot_middle, memory_order_relaxed ) & ANALYSIS_SLOT_FRESH ) == 0 ) {
+		return NULL;
+	}
+
+	analysis_slot_front = atomic_exchange_explicit( &analysis_slot_middle,
+			analysis_slot_front, memory_order_acq_rel ) & ANALYSIS_SLOT_INDEX;
+
+	return &analysis_slots[ analysis_slot_front ];
+}
+
+/* main thread, draws the latest eval of the shown ply if it changed; the */
+/* engines may publish many times between two frames */
+static void analysis_draw()
+{
+	const AnalysisSlot* slot = analysis_take();
+
+	/* analysis_shown is only written by this thread */
+	if ( slot != NULL && slot->ply == analysis_shown && analysis_show != NULL ) {
+		analysis_show( &slot->snapshot, (void*) &analysis_plies[ slot->ply ] );
+	}
+}
+
+static int analysis_ms_left( const struct timespec* until )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	long ms = ( until->tv_sec - now.tv_sec ) * 1000L + ( until->tv_nsec - now.tv_nsec ) / 1000000L;
+
+	return ( ms > 0 ) ? (int) ms : 0;
+}
@@ -0,0 +1,48 @@
+#ifndef __analysis_h__
+#define __analysis_h__
+
+#include "chess.h"
+#include "chesspack.h"
+#include "defs.h"
+#include "engine.h"
+
+#include <stdbool.h>
+
+/* analysis of a whole decoded game: while one position is on the board the */
+/* engines of the pool work through it and the positions still to come, */
+/* so their evals are complete by the time they are shown, idle engines */
+/* then review the positions already shown; without an engine the */
+/* built-in evaluator runs for the shown position */
+
+typedef struct
+{
+	/* position after the move, ply 0 is the start position; packed, a */
+	/* game keeps one per ply, chesspack_unpack() where it is needed */
+	PackedPosition pos;
+
+	/* the move leading here, empty for ply 0 */
+	char long_algebraic[ CW_MAX_LONG_ALGEBRAIC_STRING ];
+
+	/* false for book positions and dead draws, they get no eval */
+	bool analyse;
+
+	/* half moves from here to the end of the game (pgn_line_to_san) */
+	int behind;
+} AnalysisPly;
+
+/* eval results are drawn through show, with the AnalysisPly as user data; */
+/* cache_depth as for evalcache */
+void analysis_init( engine_cb_func show, int cache_depth );
+
+/* plies are kept by the caller until analysis_end_game() */
+void analysis_start_game( const char* startFEN, const AnalysisPly* plies, int nbofplies );
+
+/* ply is on the board now: draws its eval if there is one yet, then keeps */
+/* the engines busy with this and later plies, searches of time_ms each, */
+/* until window_ms have passed; the latest eval of ply is drawn from here */
+/* at a bounded frame rate, not from the engine threads */
+void analysis_show_ply( int ply, int window_ms, int time_ms );
+
+void analysis_end_game();
+
+#endif /* __analysis_h__ */
@@ -0,0 +1,34 @@
+#ifndef __bitboard_h__
+#define __bitboard_h__
+
+#include <stdint.h>
+
+/* one bit per square, bit 0 = a1, bit 63 = h8 (same numbering as the board) */
+typedef uint64_t Bitboard;
+
+#define BB_EMPTY ((Bitboard) 0)
+#define BB_SQUARE( sq ) (((Bitboard) 1) << (sq))
+
+#define BB_FILE_A ((Bitboard) 0x0101010101010101ull)
+#define BB_RANK_1 ((Bitboard) 0x00000000000000ffull)
+
+#define BB_FILE( f ) (BB_FILE_A << (f))
+#define BB_RANK( r ) (BB_RANK_1 << (8 * (r)))
+
+#define BB_IS_SET( bb, sq ) ((((bb) >> (sq)) & 1) != 0)
+#define BB_COUNT( bb ) (__builtin_popcountll( bb ))
+#define BB_FIRST( bb ) (__builtin_ctzll( bb ))
+#define BB_LAST( bb ) (63 - __builtin_clzll( bb ))
+
+/* more than one bit set */
+#define BB_MANY( bb ) (((bb) & ((bb) - 1)) != 0)
+
+/* return index of lowest set bit and clear it, bb must not be empty */
+static inline int bb_pop_first( Bitboard* bb )
+{
+	int sq = BB_FIRST( *bb );
+	*bb &= *bb - 1;
+	return sq;
+}
+
+#endif /* __bitboard_h__ */
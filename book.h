@@ -0,0 +1,32 @@
+#ifndef __book_h__
+#define __book_h__
+
+#include "chess.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Polyglot opening book (.bin), memory mapped: 16 byte big endian */
+/* entries of key, move, weight and learn data, sorted by the Polyglot */
+/* key of the position they are played from */
+
+typedef struct
+{
+	ChessMove move;
+
+	/* relative to the other moves of the position, never 0 */
+	int weight;
+} BookMove;
+
+/* false if the file can't be used, no position is in book then */
+bool book_open( const char* filename );
+void book_close();
+
+/* Polyglot key of pos, castling counts for rights on the corner rooks */
+uint64_t book_key( const Position* pos );
+
+/* legal book moves of pos, highest weight first, moves must hold */
+/* CHESS_MAX_MOVES entries; returns the number of moves, 0 out of book */
+int book_moves( const Position* pos, BookMove* moves );
+
+#endif /* __book_h__ */
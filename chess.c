@@ -1,4 +1,5 @@
 #include "chess.h"
+#include "chesstables.h"
 #include "defs.h"
 #include "dbgutil.h"
 
@@ -7,6 +8,12 @@
 #include <ctype.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /************************************************************************/
 
 #define CHESS_FILE( p ) (p & 7)
@@ -24,8 +31,41 @@
 
 /************************************************************************/
 
-static bool chess_is_move_blocked(const char* board, int from, int to);
-static void chess_perform_move( char* board, int from, int to );
+static bool chess_is_move_blocked(const Position* pos, int from, int to);
+static bool chess_may_castle(const Position* pos, int kingfrom, int rookfrom);
+static Bitboard chess_reverse_attacks(const Position* pos, int to, char piece, bool capture);
+static Bitboard chess_attackers(const Position* pos, int sq, Color color);
+static Bitboard chess_attackers_through(const Position* pos, int sq, Color color,
+		Bitboard occupied);
+static Bitboard chess_ray_attacks(int from, int dir, Bitboard occupied);
+static Bitboard chess_rook_attacks(int from, Bitboard occupied);
+static Bitboard chess_bishop_attacks(int from, Bitboard occupied);
+static int chess_add_moves(ChessMove* moves, int cnt, int from, Bitboard targets);
+static int chess_add_pawn_moves(const Position* pos, ChessMove* moves, int cnt,
+		int from, Bitboard targets);
+static bool chess_is_legal_en_passant(const Position* pos, int from, int kingsq);
+static Bitboard chess_pinned(const Position* pos, Color color, int kingsq);
+static Bitboard chess_drop_illegal(const Position* pos, int to, char piece, Bitboard candidates);
+static void chess_set_square(Position* pos, int sq, char piece);
+static void chess_update_attacks(Position* pos);
+static uint64_t chess_enpassant_hash(const Position* pos);
+static uint64_t chess_castling_hash(int castling);
+
+/************************************************************************/
+
+/* castling right lost when a piece moves from or to a square, that is */
+/* the rook moved or was taken; a king move loses all rights of its color */
+static const int chess_castle_rights_lost[CW_NB_OF_SQUARES] =
+{
+	[0] = CHESS_CASTLE_WHITE(0), [1] = CHESS_CASTLE_WHITE(1),
+	[2] = CHESS_CASTLE_WHITE(2), [3] = CHESS_CASTLE_WHITE(3),
+	[4] = CHESS_CASTLE_WHITE(4), [5] = CHESS_CASTLE_WHITE(5),
+	[6] = CHESS_CASTLE_WHITE(6), [7] = CHESS_CASTLE_WHITE(7),
+	[56] = CHESS_CASTLE_BLACK(0), [57] = CHESS_CASTLE_BLACK(1),
+	[58] = CHESS_CASTLE_BLACK(2), [59] = CHESS_CASTLE_BLACK(3),
+	[60] = CHESS_CASTLE_BLACK(4), [61] = CHESS_CASTLE_BLACK(5),
+	[62] = CHESS_CASTLE_BLACK(6), [63] = CHESS_CASTLE_BLACK(7)
+};
 
 /************************************************************************/
 
@@ -50,18 +90,21 @@ static void chess_perform_move( char* board, int from, int to );
      a    b    c    d    e    f    g    h
  */
 
-bool chess_is_possible_move(const char* board, int from, int to, char piece, bool capture)
+bool chess_is_possible_move(const Position* pos, int from, int to, char piece, bool capture)
 {
 	bool ok = false;
 
+	int rookfrom = 0;
+
 	switch (piece) {
-	case 'K': /* white king */
-		ok = (CHESS_FILE_DISTANCE( from, to ) < 2 && CHESS_RANK_DISTANCE( from, to ) < 2);
-		ok = ok || (( (from == 4 && to == 2) || (from == 4 && to == 6) ) && !capture);
-		break;
+	case 'K':
 	case 'k':
+		if (chess_is_castling(pos, piece, from, to, NULL, &rookfrom, NULL)) {
+			/* king and rook cross each other in Chess960, */
+			/* chess_may_castle() checks the squares in between */
+			return chess_may_castle(pos, from, rookfrom);
+		}
 		ok = (CHESS_FILE_DISTANCE( from, to ) < 2 && CHESS_RANK_DISTANCE( from, to ) < 2);
-		ok = ok || (( (from == 60 && to == 58) || (from == 60 && to == 62) ) && !capture);
 		break;
 
 	case 'Q':
@@ -114,201 +157,857 @@ bool chess_is_possible_move(const char* board, int from, int to, char piece, boo
 
 	/* knights can fly, other pieces can be blocked */
 	if (ok && 'N' != piece && 'n' != piece) {
-		ok = !chess_is_move_blocked(board, from, to);
+		ok = !chess_is_move_blocked(pos, from, to);
 	}
 
 	return ok;
 }
 
-bool chess_is_in_check(const char* board, char kingpiece)
+bool chess_is_in_check(const Position* pos, char kingpiece)
 {
-	/* find king */
-	int to = -1;
-	for (int i = 0; 0 > to && i < CW_NB_OF_SQUARES; ++i) {
-		if (board[i] == kingpiece) {
-			to = i;
-		}
-	}
+	Bitboard king = pos->pieces[chess_piece_index(kingpiece)];
 
-	dbgutil_test(0 <= to); /* there SHOULD be a king */
+	dbgutil_test(BB_EMPTY != king); /* there SHOULD be a king */
 
-	bool whiteking = isupper(kingpiece);
+	Color enemy = isupper(kingpiece) ? BLACK : WHITE;
 
-	for (int i = 0; i < CW_NB_OF_SQUARES; ++i) {
-		if (CW_NO_PIECE != board[i]) {
-			if ( (whiteking && islower(board[i])) || (!whiteking && isupper(board[i])) ) {
-				if ( chess_is_possible_move(board, i, to, board[i], true) ) {
-					return true;
-				}
-			}
-		}
+	return BB_EMPTY != (king & pos->attacks[enemy]);
+}
+
+bool chess_is_mated(const Position* pos, char kingpiece)
+{
+	Color color = isupper(kingpiece) ? WHITE : BLACK;
+
+	Position tmppos;
+	if (color != pos->tomove) {
+		/* moves are generated for the side to move only */
+		memcpy(&tmppos, pos, sizeof(Position));
+		tmppos.tomove = color;
+		tmppos.enpassant = CHESS_NO_SQUARE;
+		pos = &tmppos;
 	}
 
-	return false;
+	ChessMove moves[CHESS_MAX_MOVES];
+	return 0 == chess_legal_moves(pos, moves);
 }
 
-bool chess_is_mated(const char* board, char kingpiece)
+bool chess_is_insufficient_material(const Position* pos)
 {
-	bool kingwhite = (isupper( kingpiece ) != 0);
-	for ( int i = 0; i < CW_NB_OF_SQUARES; ++i ) {
+	dbgutil_test(NULL != pos);
 
-		bool fromwhite = (isupper( board[i] ) != 0);
-		if ( board[i] != CW_NO_PIECE && fromwhite == kingwhite ) {
+	const Bitboard lightsquares = 0x55AA55AA55AA55AAULL;
 
-			for ( int j = 0; j < CW_NB_OF_SQUARES; ++j ) {
-
-				bool towhite = (isupper( board[j] ) != 0);
-				bool capture = ( board[j] != CW_NO_PIECE && towhite != kingwhite );
-				if ( capture || board[j] == CW_NO_PIECE ) {
+	Bitboard heavy = pos->pieces[chess_piece_index('P')] | pos->pieces[chess_piece_index('p')] |
+		pos->pieces[chess_piece_index('R')] | pos->pieces[chess_piece_index('r')] |
+		pos->pieces[chess_piece_index('Q')] | pos->pieces[chess_piece_index('q')];
+	if (heavy != BB_EMPTY) {
+		return false;
+	}
 
-					if ( chess_is_possible_move( board, i, j, board[ i ], capture) &&
-						!chess_is_castling( board, board[ i ], i, j, NULL, NULL)) {
+	Bitboard knights = pos->pieces[chess_piece_index('N')] | pos->pieces[chess_piece_index('n')];
+	Bitboard bishops = pos->pieces[chess_piece_index('B')] | pos->pieces[chess_piece_index('b')];
 
-						char board_copy[ CW_NB_OF_SQUARES ];
-						memcpy( board_copy, board, CW_NB_OF_SQUARES );
-						chess_perform_move( board_copy, i, j );
-						if ( !chess_is_in_check( board_copy, kingpiece ) ) {
-							return false;
-						}
-					}
-				}
-			}
-		}
+	if (BB_COUNT(knights | bishops) <= 1) {
+		return true;
 	}
 
-	return true;
+	/* with more than one minor piece only same colored bishops are dead */
+	if (knights != BB_EMPTY) {
+		return false;
+	}
+	return (bishops & lightsquares) == BB_EMPTY || (bishops & ~lightsquares) == BB_EMPTY;
 }
 
-bool chess_is_en_passant_capture(const char* board, char piece, int from, int to)
+bool chess_is_en_passant_capture(const Position* pos, char piece, int from, int to)
 {
-	dbgutil_test(NULL != board);
+	dbgutil_test(NULL != pos);
 
 	if ('P' != piece && 'p' != piece) {
 		/* not even a pawn move, ...come on */
 		return false;
 	}
 
-	if (1 != CHESS_RANK_DISTANCE(from, to)) {
-		/* you really should go forward */
+	if (CHESS_NO_SQUARE == pos->enpassant || to != pos->enpassant) {
+		/* last move was no double push passing the destination */
 		return false;
 	}
 
-	if (1 != CHESS_FILE_DISTANCE(from, to)) {
+	if (1 != CHESS_RANK_DISTANCE(from, to) || 1 != CHESS_FILE_DISTANCE(from, to)) {
 		/* en passant means a pawn take is involved */
 		return false;
 	}
 
-	if ( CW_NO_PIECE != board[to] ) {
-		/* did take something else on destination */
+	/* and it has to go forward */
+	return ('P' == piece) ? (from < to) : (from > to);
+}
+
+bool chess_is_castling(const Position* pos, char piece, int from, int to,
+		int* kingto, int* rookfrom, int* rookto)
+{
+	if ( piece != 'k' && piece != 'K' ) {
 		return false;
 	}
 
-	if ('P' == piece) {
-		/* white pawn */
-		if (4 != CHESS_RANK(from)) {
-			/* not fifth rank */
-			return false;
-		}
+	int base = ( piece == 'K' ) ? 0 : 56;
+	if ( CHESS_RANK( from ) != CHESS_RANK( base ) || CHESS_RANK( to ) != CHESS_RANK( base ) ) {
+		return false;
+	}
 
-		if ('p' != board[to - 8]) {
-			/* hmm, no black pawn here */
-			return false;
-		}
-	} else if ('p' == piece) {
-		/* black pawn */
-		if (3 != CHESS_RANK(from)) {
-			/* not from fourth rank */
-			return false;
+	Bitboard rooks = CHESS_CASTLE_ROOKS( pos->castling ) & BB_RANK( CHESS_RANK( base ) );
+	int rook = CHESS_NO_SQUARE;
+
+	if ( BB_IS_SET( rooks, to ) ) {
+		/* king takes own rook */
+		rook = to;
+	} else if ( 2 == CHESS_FILE_DISTANCE( from, to ) ) {
+		/* outermost rook with a right on that side */
+		if ( to > from ) {
+			rooks &= ~( ( BB_SQUARE( from ) << 1 ) - 1 );
+			rook = ( BB_EMPTY != rooks ) ? BB_LAST( rooks ) : CHESS_NO_SQUARE;
+		} else {
+			rooks &= BB_SQUARE( from ) - 1;
+			rook = ( BB_EMPTY != rooks ) ? BB_FIRST( rooks ) : CHESS_NO_SQUARE;
 		}
 
-		if ('P' != board[to + 8]) {
-			return false;
+		if ( rook == CHESS_NO_SQUARE && from == base + 4 ) {
+			/* no right at all, take the corner as always */
+			rook = ( to > from ) ? base + 7 : base;
 		}
+	}
 
+	if ( rook == CHESS_NO_SQUARE ) {
+		return false;
+	}
+
+	/* king ends up on the g or c file, the rook next to it */
+	bool kingside = rook > from;
+	int kingdest = base + ( kingside ? 6 : 2 );
+	if ( to != rook && to != kingdest ) {
+		return false;
+	}
+
+	if ( kingto != NULL ) {
+		*kingto = kingdest;
+	}
+	if ( rookfrom != NULL ) {
+		*rookfrom = rook;
+	}
+	if ( rookto != NULL ) {
+		*rookto = base + ( kingside ? 5 : 3 );
 	}
 
 	return true;
 }
 
-bool chess_is_castling(const char* board, char piece, int from, int to,
-		int* rookfrom, int* rookto)
+int chess_piece_index(char piece)
 {
-	if ( piece != 'k' && piece != 'K' ) {
-		return false;
+	switch (piece) {
+	case 'P': return 0;
+	case 'N': return 1;
+	case 'B': return 2;
+	case 'R': return 3;
+	case 'Q': return 4;
+	case 'K': return 5;
+	case 'p': return 6;
+	case 'n': return 7;
+	case 'b': return 8;
+	case 'r': return 9;
+	case 'q': return 10;
+	case 'k': return 11;
 	}
 
-	int ffrom = CHESS_FILE( from );
-	if ( ffrom != 4 ) {
-		return false;
+	return -1;
+}
+
+void chess_setup_position(Position* pos)
+{
+	dbgutil_test(NULL != pos);
+
+	memset(pos->pieces, 0, sizeof(pos->pieces));
+	memset(pos->occupied, 0, sizeof(pos->occupied));
+	pos->hash = 0;
+
+	/* branch free occupancy first (vectorizes), then visit pieces only */
+	Bitboard occupied = BB_EMPTY;
+	for (int sq = 0; sq < CW_NB_OF_SQUARES; ++sq) {
+		occupied |= (Bitboard) (CW_NO_PIECE != pos->board[sq]) << sq;
 	}
 
-	int fto = CHESS_FILE( to );
-	if ( fto != 2 && fto != 6 ) {
-		return false;
+	while (BB_EMPTY != occupied) {
+		int sq = bb_pop_first(&occupied);
+		int idx = chess_piece_index(pos->board[sq]);
+		dbgutil_test(0 <= idx);
+		pos->pieces[idx] |= BB_SQUARE(sq);
+		pos->occupied[idx < CW_NB_OF_PIECES / 2 ? WHITE : BLACK] |= BB_SQUARE(sq);
+		pos->hash ^= chess_zobrist_pieces[idx][sq];
+	}
+
+	pos->hash ^= chess_castling_hash(pos->castling);
+	pos->hash ^= chess_enpassant_hash(pos);
+	if (BLACK == pos->tomove) {
+		pos->hash ^= chess_zobrist_black;
 	}
 
-	if ( rookfrom != NULL && rookto != NULL ) {
+	chess_update_attacks(pos);
+}
 
-		if ( fto == 6 ) {
-			*rookfrom = to + 1;
-			*rookto = to - 1;
-		} else {
-			*rookfrom = to - 2;
-			*rookto = to + 1;
-		}
+int chess_find_from_square(const Position* pos, int to, char piece, bool capture,
+		int disambiguityfile, int disambiguityrank)
+{
+	dbgutil_test(NULL != pos);
+
+	int idx = chess_piece_index(piece);
+	if (0 > idx) {
+		return CHESS_NO_SQUARE;
 	}
 
-	return true;
+	/* pieces of this kind that could reach destination on the current board */
+	Bitboard candidates = pos->pieces[idx] & chess_reverse_attacks(pos, to, piece, capture);
+
+	if (0 <= disambiguityfile) {
+		candidates &= BB_FILE(disambiguityfile);
+	}
+	if (0 <= disambiguityrank) {
+		candidates &= BB_RANK(disambiguityrank);
+	}
+
+	if (!BB_MANY(candidates)) {
+		/* SAN is only disambiguated between legal moves, */
+		/* so a single candidate is the move */
+		return (BB_EMPTY != candidates) ? BB_FIRST(candidates) : CHESS_NO_SQUARE;
+	}
+
+	candidates = chess_drop_illegal(pos, to, piece, candidates);
+
+	return (BB_EMPTY != candidates) ? BB_FIRST(candidates) : CHESS_NO_SQUARE;
 }
 
-/************************************************************************/
+Bitboard chess_legal_sources(const Position* pos, int to, char piece, bool capture)
+{
+	dbgutil_test(NULL != pos);
 
-static bool chess_is_move_blocked(const char* board, int from, int to)
+	int idx = chess_piece_index(piece);
+	if (0 > idx) {
+		return BB_EMPTY;
+	}
+
+	Bitboard candidates = pos->pieces[idx] & chess_reverse_attacks(pos, to, piece, capture);
+	if (!BB_MANY(candidates)) {
+		return candidates;
+	}
+
+	return chess_drop_illegal(pos, to, piece, candidates);
+}
+
+int chess_legal_moves(const Position* pos, ChessMove* moves)
 {
-	int xdiff = CHESS_FILE( to ) - CHESS_FILE(from);
-	int xdir = xdiff != 0 ? (xdiff / abs(xdiff)) : 0;
+	dbgutil_test(NULL != pos);
+	dbgutil_test(NULL != moves);
+
+	Color color = pos->tomove;
+	Color enemy = (WHITE == color) ? BLACK : WHITE;
+	int offset = (WHITE == color) ? 0 : 6;
+
+	Bitboard king = pos->pieces[offset + 5];
+	if (BB_EMPTY == king) {
+		return 0;
+	}
 
-	int ydiff = CHESS_RANK( to ) - CHESS_RANK(from);
-	int ydir = ydiff != 0 ? (ydiff / abs(ydiff)) : 0;
+	int kingsq = BB_FIRST(king);
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+	Bitboard checkers = pos->checkers[color];
+	int cnt = 0;
 
-	int x = CHESS_FILE(from);
-	int y = CHESS_RANK(from);
+	/* king steps, the attack map already looks through the king */
+	cnt = chess_add_moves(moves, cnt, kingsq,
+			chess_king_attacks[kingsq] & ~pos->occupied[color] & ~pos->attacks[enemy]);
 
-	x += xdir;
-	y += ydir;
+	if (BB_MANY(checkers)) {
+		/* double check, only the king can move */
+		return cnt;
+	}
+
+	/* castling, not out of, through or into check */
+	Bitboard rooks = CHESS_CASTLE_ROOKS(pos->castling) & pos->pieces[offset + 3] &
+		BB_RANK(CHESS_RANK(kingsq));
+	if (BB_EMPTY == checkers) {
+		while (BB_EMPTY != rooks) {
+			int rook = bb_pop_first(&rooks);
+			bool kingside = rook > kingsq;
+			int kingto = (kingsq & ~7) + (kingside ? 6 : 2);
+			if (!chess_may_castle(pos, kingsq, rook) ||
+					BB_EMPTY != ((chess_between[kingsq][kingto] | BB_SQUARE(kingto)) &
+						pos->attacks[enemy])) {
+				continue;
+			}
 
-	while (((y * 8) + x) != to) {
-		if (CW_NO_PIECE != board[((y * 8) + x)]) {
-			return true;
+			/* a Chess960 rook beyond the king's square may have */
+			/* shielded it from a rook or queen on the same rank */
+			Bitboard xray = chess_ray_attacks(kingto,
+					kingside ? CHESS_RAY_EAST : CHESS_RAY_WEST,
+					occupied & ~BB_SQUARE(rook) & ~king);
+			if (BB_EMPTY != (xray & (pos->pieces[6 - offset + 3] | pos->pieces[6 - offset + 4]))) {
+				continue;
+			}
+
+			/* king takes own rook when two files would be ambiguous */
+			moves[cnt].from = kingsq;
+			moves[cnt].to = (2 == CHESS_FILE_DISTANCE(kingsq, kingto)) ? kingto : rook;
+			moves[cnt].promotepiece = CW_NO_PIECE;
+			cnt++;
+		}
+	}
+
+	/* in check the other pieces must take the checker or block */
+	Bitboard targets = ~pos->occupied[color];
+	if (BB_EMPTY != checkers) {
+		int checker = BB_FIRST(checkers);
+		targets &= chess_between[kingsq][checker] | checkers;
+	}
+
+	Bitboard pinned = pos->pinned[color];
+	Bitboard pieces = pos->occupied[color] & ~king;
+	while (BB_EMPTY != pieces) {
+		int from = bb_pop_first(&pieces);
+		int idx = chess_piece_index(pos->board[from]) - offset;
+
+		Bitboard to = targets;
+		if (BB_IS_SET(pinned, from)) {
+			to &= chess_line[kingsq][from];
 		}
 
-		x += xdir;
-		y += ydir;
+		switch (idx) {
+		case 0:
+			cnt = chess_add_pawn_moves(pos, moves, cnt, from, to);
+			if (CHESS_NO_SQUARE != pos->enpassant &&
+					BB_IS_SET(chess_pawn_attacks[color][from], pos->enpassant) &&
+					chess_is_legal_en_passant(pos, from, kingsq)) {
+				moves[cnt].from = from;
+				moves[cnt].to = pos->enpassant;
+				moves[cnt].promotepiece = CW_NO_PIECE;
+				cnt++;
+			}
+			break;
+		case 1:
+			cnt = chess_add_moves(moves, cnt, from, chess_knight_attacks[from] & to);
+			break;
+		case 2:
+			cnt = chess_add_moves(moves, cnt, from,
+					chess_bishop_attacks(from, occupied) & to);
+			break;
+		case 3:
+			cnt = chess_add_moves(moves, cnt, from,
+					chess_rook_attacks(from, occupied) & to);
+			break;
+		case 4:
+			cnt = chess_add_moves(moves, cnt, from,
+					(chess_rook_attacks(from, occupied) |
+						chess_bishop_attacks(from, occupied)) & to);
+			break;
+		}
 	}
 
-	return false;
+	dbgutil_test(CHESS_MAX_MOVES >= cnt);
+
+	return cnt;
 }
 
-static void chess_perform_move( char* board, int from, int to )
+Bitboard chess_board_diff(const char* before, const char* after)
 {
-	char piece = board[from];
+	dbgutil_test(NULL != before);
+	dbgutil_test(NULL != after);
+
+	/* one bit per equal byte, then everything else has changed */
+	Bitboard same = BB_EMPTY;
+
+#if defined(__AVX2__)
+	for (int i = 0; i < CW_NB_OF_SQUARES; i += 32) {
+		__m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (before + i)),
+				_mm256_loadu_si256((const __m256i*) (after + i)));
+		same |= (Bitboard) (uint32_t) _mm256_movemask_epi8(eq) << i;
+	}
+#elif defined(__SSE2__)
+	for (int i = 0; i < CW_NB_OF_SQUARES; i += 16) {
+		__m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (before + i)),
+				_mm_loadu_si128((const __m128i*) (after + i)));
+		same |= (Bitboard) (uint16_t) _mm_movemask_epi8(eq) << i;
+	}
+#else
+	for (int sq = 0; sq < CW_NB_OF_SQUARES; ++sq) {
+		same |= (Bitboard) (before[sq] == after[sq]) << sq;
+	}
+#endif
 
-	if (chess_is_en_passant_capture(board, piece, from, to)) {
+	return ~same;
+}
+
+void chess_perform_move(Position* pos, int from, int to, char promotepiece)
+{
+	dbgutil_test(NULL != pos);
+
+	char piece = pos->board[from];
+	bool capture = (CW_NO_PIECE != pos->board[to]);
+
+	/* state that changes below, taken out of the hash and put back later */
+	pos->hash ^= chess_castling_hash(pos->castling) ^ chess_enpassant_hash(pos);
+
+	if (chess_is_en_passant_capture(pos, piece, from, to)) {
 		if ('p' == piece) {
-			board[to + 8] = CW_NO_PIECE;
+			chess_set_square(pos, to + 8, CW_NO_PIECE);
 		} else {
-			board[to - 8] = CW_NO_PIECE;
+			chess_set_square(pos, to - 8, CW_NO_PIECE);
 		}
+		capture = true;
 	}
 
+	int kingto = 0;
 	int rookfrom = 0;
 	int rookto = 0;
-	if ( chess_is_castling( board, piece, from, to,
-			&rookfrom, &rookto) ) {
-		board[ rookto ] = board[ rookfrom ];
-		board[ rookfrom ] = CW_NO_PIECE;
+	if ( chess_is_castling( pos, piece, from, to,
+			&kingto, &rookfrom, &rookto) ) {
+		/* in Chess960 either may land where the other stood, */
+		/* so both leave the board first */
+		char rook = pos->board[ rookfrom ];
+		chess_set_square( pos, rookfrom, CW_NO_PIECE );
+		chess_set_square( pos, from, CW_NO_PIECE );
+		chess_set_square( pos, rookto, rook );
+		chess_set_square( pos, kingto, piece );
+		capture = false;
+	} else {
+		chess_set_square(pos, from, CW_NO_PIECE);
+		if ( promotepiece != CW_NO_PIECE ) {
+			chess_set_square(pos, to, promotepiece);
+		} else {
+			chess_set_square(pos, to, piece);
+		}
+	}
+
+	/* king leaving home, rook leaving home or rook captured at home */
+	if ('K' == piece) {
+		pos->castling &= ~CHESS_CASTLE_WHITE_ALL;
+	} else if ('k' == piece) {
+		pos->castling &= ~CHESS_CASTLE_BLACK_ALL;
+	}
+	pos->castling &= ~(chess_castle_rights_lost[from] | chess_castle_rights_lost[to]);
+
+	bool pawn = ('P' == piece || 'p' == piece);
+	if (pawn && 2 == CHESS_RANK_DISTANCE(from, to)) {
+		pos->enpassant = (from + to) / 2;
+	} else {
+		pos->enpassant = CHESS_NO_SQUARE;
+	}
+
+	if (pawn || capture) {
+		pos->halfmove = 0;
+	} else {
+		pos->halfmove++;
+	}
+
+	if (BLACK == pos->tomove) {
+		pos->fullmove++;
+		pos->tomove = WHITE;
+	} else {
+		pos->tomove = BLACK;
+	}
+
+	pos->hash ^= chess_zobrist_black;
+	pos->hash ^= chess_castling_hash(pos->castling) ^ chess_enpassant_hash(pos);
+
+	chess_update_attacks(pos);
+}
+
+/************************************************************************/
+
+static bool chess_is_move_blocked(const Position* pos, int from, int to)
+{
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+
+	return BB_EMPTY != (chess_between[from][to] & occupied);
+}
+
+static Bitboard chess_drop_illegal(const Position* pos, int to, char piece, Bitboard candidates)
+{
+	/* drop the pinned ones leaving the pin line */
+	Color color = isupper(piece) ? WHITE : BLACK;
+	char kingpiece = (WHITE == color) ? 'K' : 'k';
+	Bitboard king = pos->pieces[chess_piece_index(kingpiece)];
+	if (BB_EMPTY == king) {
+		return candidates;
+	}
+
+	int kingsq = BB_FIRST(king);
+	Bitboard pinned = candidates & pos->pinned[color];
+	while (BB_EMPTY != pinned) {
+		int from = bb_pop_first(&pinned);
+		if (!BB_IS_SET(chess_line[kingsq][from], to)) {
+			candidates &= ~BB_SQUARE(from);
+		}
+	}
+
+	if (BB_MANY(candidates) && BB_EMPTY != pos->checkers[color]) {
+		/* rare, only the candidate that resolves check is legal */
+		Bitboard rest = candidates;
+		while (BB_EMPTY != rest) {
+			int from = bb_pop_first(&rest);
+
+			Position tmppos;
+			memcpy(&tmppos, pos, sizeof(Position));
+			chess_perform_move(&tmppos, from, to, CW_NO_PIECE);
+			if (chess_is_in_check(&tmppos, kingpiece)) {
+				candidates &= ~BB_SQUARE(from);
+			}
+		}
+	}
+
+	return candidates;
+}
+
+static Bitboard chess_attackers(const Position* pos, int sq, Color color)
+{
+	return chess_attackers_through(pos, sq, color, pos->occupied[WHITE] | pos->occupied[BLACK]);
+}
+
+static Bitboard chess_attackers_through(const Position* pos, int sq, Color color,
+		Bitboard occupied)
+{
+	/* pieces of color attacking sq, sliders see through what is not in occupied */
+	int offset = (WHITE == color) ? 0 : 6;
+	Color other = (WHITE == color) ? BLACK : WHITE;
+
+	Bitboard queens = pos->pieces[offset + 4];
+	Bitboard result =
+		(chess_pawn_attacks[other][sq] & pos->pieces[offset + 0]) |
+		(chess_knight_attacks[sq] & pos->pieces[offset + 1]) |
+		(chess_king_attacks[sq] & pos->pieces[offset + 5]);
+
+	Bitboard sliders =
+		(chess_rook_rays[sq] & (pos->pieces[offset + 3] | queens)) |
+		(chess_bishop_rays[sq] & (pos->pieces[offset + 2] | queens));
+
+	/* sliders need a free line, this covers discovered attacks as well */
+	while (BB_EMPTY != sliders) {
+		int from = bb_pop_first(&sliders);
+		if (BB_EMPTY == (chess_between[from][sq] & occupied)) {
+			result |= BB_SQUARE(from);
+		}
+	}
+
+	return result;
+}
+
+static Bitboard chess_ray_attacks(int from, int dir, Bitboard occupied)
+{
+	/* the ray up to and including the nearest blocker */
+	Bitboard ray = chess_rays[dir][from];
+	Bitboard blockers = ray & occupied;
+	if (BB_EMPTY != blockers) {
+		int blocker = (CHESS_RAY_SOUTH > dir) ? BB_FIRST(blockers) : BB_LAST(blockers);
+		ray ^= chess_rays[dir][blocker];
+	}
+
+	return ray;
+}
+
+static Bitboard chess_rook_attacks(int from, Bitboard occupied)
+{
+	return chess_ray_attacks(from, CHESS_RAY_NORTH, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_EAST, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_SOUTH, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_WEST, occupied);
+}
+
+static Bitboard chess_bishop_attacks(int from, Bitboard occupied)
+{
+	return chess_ray_attacks(from, CHESS_RAY_NORTH_EAST, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_NORTH_WEST, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_SOUTH_WEST, occupied) |
+		chess_ray_attacks(from, CHESS_RAY_SOUTH_EAST, occupied);
+}
+
+static int chess_add_moves(ChessMove* moves, int cnt, int from, Bitboard targets)
+{
+	while (BB_EMPTY != targets) {
+		moves[cnt].from = from;
+		moves[cnt].to = bb_pop_first(&targets);
+		moves[cnt].promotepiece = CW_NO_PIECE;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+static int chess_add_pawn_moves(const Position* pos, ChessMove* moves, int cnt,
+		int from, Bitboard targets)
+{
+	Color color = pos->tomove;
+	Color enemy = (WHITE == color) ? BLACK : WHITE;
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+
+	int step = (WHITE == color) ? 8 : -8;
+	int homerank = (WHITE == color) ? 1 : 6;
+
+	Bitboard to = chess_pawn_attacks[color][from] & pos->occupied[enemy];
+	if (!BB_IS_SET(occupied, from + step)) {
+		to |= BB_SQUARE(from + step);
+		if (homerank == CHESS_RANK(from) && !BB_IS_SET(occupied, from + 2 * step)) {
+			to |= BB_SQUARE(from + 2 * step);
+		}
+	}
+	to &= targets;
+
+	const char* promotions = (WHITE == color) ? "QRBN" : "qrbn";
+	while (BB_EMPTY != to) {
+		int sq = bb_pop_first(&to);
+		if (0 == CHESS_RANK(sq) || 7 == CHESS_RANK(sq)) {
+			for (const char* p = promotions; CW_NO_PIECE != *p; ++p) {
+				moves[cnt].from = from;
+				moves[cnt].to = sq;
+				moves[cnt].promotepiece = *p;
+				cnt++;
+			}
+		} else {
+			moves[cnt].from = from;
+			moves[cnt].to = sq;
+			moves[cnt].promotepiece = CW_NO_PIECE;
+			cnt++;
+		}
 	}
 
-	board[from] = CW_NO_PIECE;
-	board[to] = piece;
+	return cnt;
+}
+
+static bool chess_is_legal_en_passant(const Position* pos, int from, int kingsq)
+{
+	/* two pawns leave the line at once, just try it (rare enough) */
+	Position tmppos;
+	memcpy(&tmppos, pos, sizeof(Position));
+	chess_perform_move(&tmppos, from, pos->enpassant, CW_NO_PIECE);
+
+	Color enemy = (WHITE == pos->tomove) ? BLACK : WHITE;
+	return BB_EMPTY == chess_attackers(&tmppos, kingsq, enemy);
+}
+
+static Bitboard chess_reverse_attacks(const Position* pos, int to, char piece, bool capture)
+{
+	Bitboard result = BB_EMPTY;
+	Bitboard sliders = BB_EMPTY;
+
+	switch (piece) {
+	case 'N':
+	case 'n':
+		return chess_knight_attacks[to];
+
+	case 'K':
+	case 'k':
+		return chess_king_attacks[to];
+
+	case 'P':
+		if (capture) {
+			/* a white pawn attacks to from where a black pawn on to would attack */
+			return chess_pawn_attacks[BLACK][to];
+		}
+		if (8 <= to) {
+			result = BB_SQUARE(to - 8);
+			if (3 == CHESS_RANK(to) && CW_NO_PIECE == pos->board[to - 8]) {
+				result |= BB_SQUARE(to - 16);
+			}
+		}
+		return result;
+
+	case 'p':
+		if (capture) {
+			return chess_pawn_attacks[WHITE][to];
+		}
+		if (56 > to) {
+			result = BB_SQUARE(to + 8);
+			if (4 == CHESS_RANK(to) && CW_NO_PIECE == pos->board[to + 8]) {
+				result |= BB_SQUARE(to + 16);
+			}
+		}
+		return result;
+
+	case 'R':
+	case 'r':
+		sliders = chess_rook_rays[to];
+		break;
+
+	case 'B':
+	case 'b':
+		sliders = chess_bishop_rays[to];
+		break;
+
+	case 'Q':
+	case 'q':
+		sliders = chess_rook_rays[to] | chess_bishop_rays[to];
+		break;
+	}
+
+	/* sliders only of this kind, and with nothing in between */
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+	sliders &= pos->pieces[chess_piece_index(piece)];
+	while (BB_EMPTY != sliders) {
+		int from = bb_pop_first(&sliders);
+		if (BB_EMPTY == (chess_between[from][to] & occupied)) {
+			result |= BB_SQUARE(from);
+		}
+	}
+
+	return result;
+}
+
+static Bitboard chess_pinned(const Position* pos, Color color, int kingsq)
+{
+	Color enemy = (WHITE == color) ? BLACK : WHITE;
+	int offset = (WHITE == enemy) ? 0 : 6;
+
+	Bitboard queens = pos->pieces[offset + 4];
+	Bitboard snipers =
+		(chess_rook_rays[kingsq] & (pos->pieces[offset + 3] | queens)) |
+		(chess_bishop_rays[kingsq] & (pos->pieces[offset + 2] | queens));
+
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+	Bitboard result = BB_EMPTY;
+	while (BB_EMPTY != snipers) {
+		int sq = bb_pop_first(&snipers);
+		Bitboard between = chess_between[kingsq][sq] & occupied;
+		if (!BB_MANY(between)) {
+			/* a lonely own piece in between is pinned */
+			result |= between & pos->occupied[color];
+		}
+	}
+
+	return result;
+}
+
+static void chess_set_square(Position* pos, int sq, char piece)
+{
+	Bitboard bit = BB_SQUARE(sq);
+
+	int old = chess_piece_index(pos->board[sq]);
+	if (0 <= old) {
+		pos->pieces[old] &= ~bit;
+		pos->occupied[(6 > old) ? WHITE : BLACK] &= ~bit;
+		pos->hash ^= chess_zobrist_pieces[old][sq];
+	}
+
+	int idx = chess_piece_index(piece);
+	if (0 <= idx) {
+		pos->pieces[idx] |= bit;
+		pos->occupied[(6 > idx) ? WHITE : BLACK] |= bit;
+		pos->hash ^= chess_zobrist_pieces[idx][sq];
+	}
+
+	pos->board[sq] = piece;
+}
+
+static uint64_t chess_enpassant_hash(const Position* pos)
+{
+	if (CHESS_NO_SQUARE == pos->enpassant) {
+		return 0;
+	}
+
+	/* a double push only changes the position if it can be taken */
+	Color other = (WHITE == pos->tomove) ? BLACK : WHITE;
+	int pawn = (WHITE == pos->tomove) ? 0 : 6;
+	if (BB_EMPTY == (chess_pawn_attacks[other][pos->enpassant] & pos->pieces[pawn])) {
+		return 0;
+	}
+
+	return chess_zobrist_enpassant[CHESS_FILE(pos->enpassant)];
+}
+
+static uint64_t chess_castling_hash(int castling)
+{
+	/* one key per rook file right */
+	uint64_t hash = 0;
+	Bitboard rights = (Bitboard) castling;
+	while (BB_EMPTY != rights) {
+		hash ^= chess_zobrist_castling[bb_pop_first(&rights)];
+	}
+
+	return hash;
+}
+
+static bool chess_may_castle(const Position* pos, int kingfrom, int rookfrom)
+{
+	if (!BB_IS_SET(CHESS_CASTLE_ROOKS(pos->castling), rookfrom) ||
+			CHESS_RANK(kingfrom) != CHESS_RANK(rookfrom)) {
+		return false;
+	}
+
+	char king = pos->board[kingfrom];
+	char rook = pos->board[rookfrom];
+	if (!(('K' == king && 'R' == rook) || ('k' == king && 'r' == rook))) {
+		return false;
+	}
+
+	bool kingside = rookfrom > kingfrom;
+	int base = kingfrom & ~7;
+	int kingto = base + (kingside ? 6 : 2);
+	int rookto = base + (kingside ? 5 : 3);
+
+	/* nothing but king and rook on the squares they pass or land on */
+	Bitboard path = chess_between[kingfrom][kingto] | BB_SQUARE(kingto) |
+		chess_between[rookfrom][rookto] | BB_SQUARE(rookto);
+	Bitboard occupied = (pos->occupied[WHITE] | pos->occupied[BLACK]) &
+		~BB_SQUARE(kingfrom) & ~BB_SQUARE(rookfrom);
+
+	return BB_EMPTY == (path & occupied);
+}
+
+static void chess_update_attacks(Position* pos)
+{
+	Bitboard occupied = pos->occupied[WHITE] | pos->occupied[BLACK];
+
+	for (int c = 0; c < 2; ++c) {
+		Color color = (Color) c;
+		Color enemy = (WHITE == color) ? BLACK : WHITE;
+		int offset = (WHITE == color) ? 0 : 6;
+
+		/* the enemy king may not step back along a line it is attacked on */
+		Bitboard through = occupied & ~pos->pieces[(WHITE == enemy) ? 5 : 11];
+
+		/* pawns all at once, the other pieces one by one */
+		Bitboard pawns = pos->pieces[offset + 0];
+		Bitboard attacks = (WHITE == color) ?
+			((pawns << 7) & ~BB_FILE(7)) | ((pawns << 9) & ~BB_FILE(0)) :
+			((pawns >> 9) & ~BB_FILE(7)) | ((pawns >> 7) & ~BB_FILE(0));
+
+		Bitboard pieces = pos->pieces[offset + 1];
+		while (BB_EMPTY != pieces) {
+			attacks |= chess_knight_attacks[bb_pop_first(&pieces)];
+		}
+
+		Bitboard queens = pos->pieces[offset + 4];
+		pieces = pos->pieces[offset + 2] | queens;
+		while (BB_EMPTY != pieces) {
+			attacks |= chess_bishop_attacks(bb_pop_first(&pieces), through);
+		}
+		pieces = pos->pieces[offset + 3] | queens;
+		while (BB_EMPTY != pieces) {
+			attacks |= chess_rook_attacks(bb_pop_first(&pieces), through);
+		}
+
+		Bitboard king = pos->pieces[offset + 5];
+		if (BB_EMPTY != king) {
+			attacks |= chess_king_attacks[BB_FIRST(king)];
+		}
+		pos->attacks[color] = attacks;
+	}
+
+	for (int c = 0; c < 2; ++c) {
+		Color color = (Color) c;
+		Color enemy = (WHITE == color) ? BLACK : WHITE;
+		Bitboard king = pos->pieces[(WHITE == color) ? 5 : 11];
+
+		pos->checkers[color] = BB_EMPTY;
+		pos->pinned[color] = BB_EMPTY;
+		if (BB_EMPTY != king) {
+			int kingsq = BB_FIRST(king);
+			if (BB_EMPTY != (king & pos->attacks[enemy])) {
+				pos->checkers[color] = chess_attackers(pos, kingsq, enemy);
+			}
+			pos->pinned[color] = chess_pinned(pos, color, kingsq);
+		}
+	}
 }
@@ -1,20 +1,143 @@
 #ifndef __chess_h__
 #define __chess_h__
 
+#include "defs.h"
+#include "bitboard.h"
+
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+	WHITE,
+	BLACK
+} Color;
+
+/* castling rights, one bit per file of a rook that may still castle, */
+/* white in the low byte and black in the high byte, which covers */
+/* Chess960 start positions as well */
+#define CHESS_CASTLE_WHITE( file ) (0x0001 << (file))
+#define CHESS_CASTLE_BLACK( file ) (0x0100 << (file))
+#define CHESS_CASTLE_WHITE_ALL 0x00ff
+#define CHESS_CASTLE_BLACK_ALL 0xff00
+
+/* the rights of the standard start position */
+#define CHESS_CASTLE_WHITE_KINGSIDE CHESS_CASTLE_WHITE( 7 )
+#define CHESS_CASTLE_WHITE_QUEENSIDE CHESS_CASTLE_WHITE( 0 )
+#define CHESS_CASTLE_BLACK_KINGSIDE CHESS_CASTLE_BLACK( 7 )
+#define CHESS_CASTLE_BLACK_QUEENSIDE CHESS_CASTLE_BLACK( 0 )
+
+/* squares of the rooks that may still castle */
+#define CHESS_CASTLE_ROOKS( castling ) \
+		(((Bitboard) ((castling) & CHESS_CASTLE_WHITE_ALL)) | \
+		 (((Bitboard) ((castling) & CHESS_CASTLE_BLACK_ALL)) << 48))
+
+#define CHESS_NO_SQUARE (-1)
+
+/* index into Position.pieces, white pieces first, see chess_piece_index() */
+#define CHESS_PIECES "PNBRQKpnbrqk"
+
+typedef struct
+{
+	char board[CW_NB_OF_SQUARES];
+
+	/* same content as board, one bitboard per piece */
+	Bitboard pieces[CW_NB_OF_PIECES];
+
+	/* all pieces per color, indexed by Color */
+	Bitboard occupied[2];
+
+	Color tomove;
+
+	/* CHESS_CASTLE_* rook file flags */
+	int castling;
+
+	/* square passed by a double pawn push on the last move, */
+	/* CHESS_NO_SQUARE if none */
+	int enpassant;
+
+	/* half moves since last capture or pawn move */
+	int halfmove;
+
+	int fullmove;
+
+	/* zobrist hash of all of the above, en passant only counts when */
+	/* the side to move has a pawn to take with */
+	uint64_t hash;
+
+	/* derived from the board once per position by chess_setup_position() */
+	/* and chess_perform_move(), all indexed by Color: */
+
+	/* squares attacked, the enemy king does not block sliders */
+	Bitboard attacks[2];
+
+	/* enemy pieces giving check to the king */
+	Bitboard checkers[2];
+
+	/* own pieces pinned to the king */
+	Bitboard pinned[2];
+} Position;
+
+/* upper bound for the number of legal moves in any position */
+#define CHESS_MAX_MOVES 256
+
+typedef struct
+{
+	int8_t from;
+	int8_t to;
+
+	/* piece in the color of the side to move, CW_NO_PIECE if none */
+	char promotepiece;
+} ChessMove;
 
 /* check if move is possible, does not check full validity, you have to check */
 /* for check also */
-bool chess_is_possible_move(const char* board, int from, int to, char piece, bool capture);
+bool chess_is_possible_move(const Position* pos, int from, int to, char piece, bool capture);
 
 /* check if a king is in check */
-bool chess_is_in_check(const char* board, char kingpiece);
+bool chess_is_in_check(const Position* pos, char kingpiece);
+
+bool chess_is_mated(const Position* pos, char kingpiece);
+
+/* neither side has mating material left: bare kings, a single minor */
+/* piece, or only bishops that all stand on squares of one color */
+bool chess_is_insufficient_material(const Position* pos);
+
+bool chess_is_en_passant_capture(const Position* pos, char piece, int from, int to);
+
+/* king move is castling: to is either the square two files away the king */
+/* ends up on or, as in Chess960, the square of the castling rook; the */
+/* resulting squares go to kingto, rookfrom and rookto unless NULL */
+bool chess_is_castling(const Position* pos, char piece, int from, int to,
+		int* kingto, int* rookfrom, int* rookto);
+
+/* index of piece in CHESS_PIECES, -1 if no piece */
+int chess_piece_index(char piece);
+
+/* complete bitboards and hash after board, side to move, castling and */
+/* en passant have been written directly */
+void chess_setup_position(Position* pos);
+
+/* find the square piece moves from to reach to, for a move in standard */
+/* algebraic notation; disambiguityfile/rank are -1 if not given */
+/* returns CHESS_NO_SQUARE if there is no legal move */
+int chess_find_from_square(const Position* pos, int to, char piece, bool capture,
+		int disambiguityfile, int disambiguityrank);
+
+/* squares a piece of this kind can legally move from to reach to, a lone */
+/* candidate is returned without checking, like SAN does */
+Bitboard chess_legal_sources(const Position* pos, int to, char piece, bool capture);
 
-bool chess_is_mated(const char* board, char kingpiece);
+/* all legal moves for the side to move, returns the number of moves */
+/* written to moves, which must hold CHESS_MAX_MOVES entries */
+int chess_legal_moves(const Position* pos, ChessMove* moves);
 
-bool chess_is_en_passant_capture(const char* board, char piece, int from, int to);
+/* squares whose piece differs between two boards (Position.board), */
+/* compared 16 or 32 squares at a time with SSE2 or AVX2 when built for it */
+Bitboard chess_board_diff(const char* before, const char* after);
 
-bool chess_is_castling(const char* board, char piece, int from, int to,
-		int* rookfrom, int* rookto);
+/* move piece on from to to, handles castling, en passant and promotion */
+/* and updates side to move, castling rights, en passant square and clocks */
+void chess_perform_move(Position* pos, int from, int to, char promotepiece);
 
 #endif /* __chess_h__ */
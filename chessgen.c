@@ -0,0 +1,245 @@
+/* build time generator for the attack tables in chesstables.c */
+/* usage: chessgen > chesstables.c */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************************************************/
+
+#define CHESSGEN_NB_OF_SQUARES 64
+
+typedef struct
+{
+	int df;
+	int dr;
+} ChessGenStep;
+
+static const ChessGenStep chessgen_knight_steps[] =
+	{ { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+
+static const ChessGenStep chessgen_king_steps[] =
+	{ { 0, 1 }, { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, -1 }, { -1, 0 }, { -1, 1 } };
+
+static const ChessGenStep chessgen_rook_steps[] =
+	{ { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+
+static const ChessGenStep chessgen_bishop_steps[] =
+	{ { 1, 1 }, { 1, -1 }, { -1, -1 }, { -1, 1 } };
+
+static const ChessGenStep chessgen_white_pawn_steps[] =
+	{ { -1, 1 }, { 1, 1 } };
+
+static const ChessGenStep chessgen_black_pawn_steps[] =
+	{ { -1, -1 }, { 1, -1 } };
+
+/* one ray per direction, the first four run towards higher squares, */
+/* see chess_rays in chesstables.h */
+static const ChessGenStep chessgen_ray_steps[] =
+	{ { 0, 1 }, { 1, 1 }, { 1, 0 }, { -1, 1 }, { 0, -1 }, { -1, -1 }, { -1, 0 }, { 1, -1 } };
+
+#define CHESSGEN_STEPS( s ) s, (int) (sizeof( s ) / sizeof( ChessGenStep ))
+
+/************************************************************************/
+
+static uint64_t chessgen_attacks( int sq, const ChessGenStep* steps, int cnt, bool slide );
+static void chessgen_print_table( const char* decl, const ChessGenStep* steps, int cnt, bool slide );
+static void chessgen_print_values( const uint64_t* values, int cnt, const char* indent );
+static void chessgen_print_square_pairs( const char* decl, bool full_line );
+static int chessgen_direction( int from, int to );
+static void chessgen_print_zobrist();
+static uint64_t chessgen_random();
+
+/************************************************************************/
+
+int main()
+{
+	printf( "/* generated by chessgen, do not edit */\n\n" );
+	printf( "#include \"chesstables.h\"\n\n" );
+
+	chessgen_print_table( "const Bitboard chess_knight_attacks[ CW_NB_OF_SQUARES ]",
+			CHESSGEN_STEPS( chessgen_knight_steps ), false );
+	chessgen_print_table( "const Bitboard chess_king_attacks[ CW_NB_OF_SQUARES ]",
+			CHESSGEN_STEPS( chessgen_king_steps ), false );
+	chessgen_print_table( "const Bitboard chess_rook_rays[ CW_NB_OF_SQUARES ]",
+			CHESSGEN_STEPS( chessgen_rook_steps ), true );
+	chessgen_print_table( "const Bitboard chess_bishop_rays[ CW_NB_OF_SQUARES ]",
+			CHESSGEN_STEPS( chessgen_bishop_steps ), true );
+
+	printf( "const Bitboard chess_rays[ 8 ][ CW_NB_OF_SQUARES ] =\n{\n" );
+	for ( int dir = 0; dir < 8; ++dir ) {
+		uint64_t values[ CHESSGEN_NB_OF_SQUARES ];
+		for ( int sq = 0; sq < CHESSGEN_NB_OF_SQUARES; ++sq ) {
+			values[ sq ] = chessgen_attacks( sq, &( chessgen_ray_steps[ dir ] ), 1, true );
+		}
+		printf( "\t{\n" );
+		chessgen_print_values( values, CHESSGEN_NB_OF_SQUARES, "\t\t" );
+		printf( "\t}%s\n", (dir < 7) ? "," : "" );
+	}
+	printf( "};\n\n" );
+
+	uint64_t pawns[ 2 * CHESSGEN_NB_OF_SQUARES ];
+	for ( int sq = 0; sq < CHESSGEN_NB_OF_SQUARES; ++sq ) {
+		pawns[ sq ] = chessgen_attacks( sq, CHESSGEN_STEPS( chessgen_white_pawn_steps ), false );
+		pawns[ CHESSGEN_NB_OF_SQUARES + sq ] =
+			chessgen_attacks( sq, CHESSGEN_STEPS( chessgen_black_pawn_steps ), false );
+	}
+	printf( "const Bitboard chess_pawn_attacks[ 2 ][ CW_NB_OF_SQUARES ] =\n{\n" );
+	printf( "\t{\n" );
+	chessgen_print_values( pawns, CHESSGEN_NB_OF_SQUARES, "\t\t" );
+	printf( "\t},\n\t{\n" );
+	chessgen_print_values( pawns + CHESSGEN_NB_OF_SQUARES, CHESSGEN_NB_OF_SQUARES, "\t\t" );
+	printf( "\t}\n};\n\n" );
+
+	chessgen_print_square_pairs( "const Bitboard chess_between[ CW_NB_OF_SQUARES ][ CW_NB_OF_SQUARES ]", false );
+	chessgen_print_square_pairs( "const Bitboard chess_line[ CW_NB_OF_SQUARES ][ CW_NB_OF_SQUARES ]", true );
+
+	chessgen_print_zobrist();
+
+	return 0;
+}
+
+/************************************************************************/
+
+static uint64_t chessgen_attacks( int sq, const ChessGenStep* steps, int cnt, bool slide )
+{
+	uint64_t result = 0;
+
+	for ( int i = 0; i < cnt; ++i ) {
+		int f = (sq & 7) + steps[ i ].df;
+		int r = (sq >> 3) + steps[ i ].dr;
+		while ( f >= 0 && f < 8 && r >= 0 && r < 8 ) {
+			result |= ((uint64_t) 1) << ((r * 8) + f);
+			if ( !slide ) {
+				break;
+			}
+			f += steps[ i ].df;
+			r += steps[ i ].dr;
+		}
+	}
+
+	return result;
+}
+
+static void chessgen_print_table( const char* decl, const ChessGenStep* steps, int cnt, bool slide )
+{
+	uint64_t values[ CHESSGEN_NB_OF_SQUARES ];
+	for ( int sq = 0; sq < CHESSGEN_NB_OF_SQUARES; ++sq ) {
+		values[ sq ] = chessgen_attacks( sq, steps, cnt, slide );
+	}
+
+	printf( "%s =\n{\n", decl );
+	chessgen_print_values( values, CHESSGEN_NB_OF_SQUARES, "\t" );
+	printf( "};\n\n" );
+}
+
+static void chessgen_print_values( const uint64_t* values, int cnt, const char* indent )
+{
+	for ( int i = 0; i < cnt; ++i ) {
+		if ( (i % 4) == 0 ) {
+			printf( "%s", indent );
+		}
+		printf( "0x%016llxull%s", (unsigned long long) values[ i ],
+				(i + 1 < cnt) ? "," : "" );
+		printf( ((i % 4) == 3 || i + 1 == cnt) ? "\n" : " " );
+	}
+}
+
+static void chessgen_print_square_pairs( const char* decl, bool full_line )
+{
+	printf( "%s =\n{\n", decl );
+
+	for ( int a = 0; a < CHESSGEN_NB_OF_SQUARES; ++a ) {
+		uint64_t values[ CHESSGEN_NB_OF_SQUARES ];
+
+		for ( int b = 0; b < CHESSGEN_NB_OF_SQUARES; ++b ) {
+			values[ b ] = 0;
+
+			int dir = chessgen_direction( a, b );
+			if ( dir == 0 ) {
+				continue;
+			}
+
+			if ( full_line ) {
+				/* walk to the board edge both ways from a */
+				int df = (b & 7) > (a & 7) ? 1 : ((b & 7) < (a & 7) ? -1 : 0);
+				int dr = (b >> 3) > (a >> 3) ? 1 : ((b >> 3) < (a >> 3) ? -1 : 0);
+				ChessGenStep steps[ 2 ] = { { df, dr }, { -df, -dr } };
+				values[ b ] = chessgen_attacks( a, steps, 2, true ) | (((uint64_t) 1) << a);
+			} else {
+				for ( int sq = a + dir; sq != b; sq += dir ) {
+					values[ b ] |= ((uint64_t) 1) << sq;
+				}
+			}
+		}
+
+		printf( "\t{\n" );
+		chessgen_print_values( values, CHESSGEN_NB_OF_SQUARES, "\t\t" );
+		printf( "\t}%s\n", (a + 1 < CHESSGEN_NB_OF_SQUARES) ? "," : "" );
+	}
+
+	printf( "};\n\n" );
+}
+
+static int chessgen_direction( int from, int to )
+{
+	/* square step from from towards to, 0 if not on a common line */
+	int df = (to & 7) - (from & 7);
+	int dr = (to >> 3) - (from >> 3);
+
+	if ( from == to ) {
+		return 0;
+	}
+	if ( df != 0 && dr != 0 && df != dr && df != -dr ) {
+		return 0;
+	}
+
+	int sf = df > 0 ? 1 : (df < 0 ? -1 : 0);
+	int sr = dr > 0 ? 1 : (dr < 0 ? -1 : 0);
+
+	return (sr * 8) + sf;
+}
+
+static void chessgen_print_zobrist()
+{
+	uint64_t values[ CHESSGEN_NB_OF_SQUARES ];
+
+	printf( "const uint64_t chess_zobrist_pieces[ CW_NB_OF_PIECES ][ CW_NB_OF_SQUARES ] =\n{\n" );
+	for ( int piece = 0; piece < 12; ++piece ) {
+		for ( int sq = 0; sq < CHESSGEN_NB_OF_SQUARES; ++sq ) {
+			values[ sq ] = chessgen_random();
+		}
+		printf( "\t{\n" );
+		chessgen_print_values( values, CHESSGEN_NB_OF_SQUARES, "\t\t" );
+		printf( "\t}%s\n", (piece < 11) ? "," : "" );
+	}
+	printf( "};\n\n" );
+
+	for ( int i = 0; i < 16; ++i ) {
+		values[ i ] = chessgen_random();
+	}
+	printf( "const uint64_t chess_zobrist_castling[ 16 ] =\n{\n" );
+	chessgen_print_values( values, 16, "\t" );
+	printf( "};\n\n" );
+
+	for ( int i = 0; i < 8; ++i ) {
+		values[ i ] = chessgen_random();
+	}
+	printf( "const uint64_t chess_zobrist_enpassant[ CW_NB_OF_FILES ] =\n{\n" );
+	chessgen_print_values( values, 8, "\t" );
+	printf( "};\n\n" );
+
+	printf( "const uint64_t chess_zobrist_black = 0x%016llxull;\n",
+			(unsigned long long) chessgen_random() );
+}
+
+static uint64_t chessgen_random()
+{
+	/* splitmix64, fixed seed so that hashes are the same for every build */
+	static uint64_t state = 0x6368657373766965ull;
+
+	uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
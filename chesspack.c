@@ -0,0 +1,67 @@
+#include "chesspack.h"
+#include "bitboard.h"
+#include "dbgutil.h"
+
+#include <string.h>
+
+/************************************************************************/
+
+_Static_assert( sizeof(PackedPosition) == 32, "PackedPosition should be 32 bytes" );
+
+/************************************************************************/
+
+bool chesspack_pack( const Position* pos, PackedPosition* packed )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( packed != NULL );
+
+	memset( packed, 0, sizeof(PackedPosition) );
+
+	/* walk the occupied squares only, the bitboards are already there */
+	Bitboard occupied = pos->occupied[ WHITE ] | pos->occupied[ BLACK ];
+	if ( BB_COUNT( occupied ) > CHESSPACK_MAX_PIECES ) {
+		return false;
+	}
+	packed->occupied = occupied;
+
+	int n = 0;
+	while ( occupied != BB_EMPTY ) {
+		int sq = bb_pop_first( &occupied );
+		uint8_t nibble = (uint8_t) (chess_piece_index( pos->board[ sq ] ) + 1);
+		packed->pieces[ n >> 1 ] |= nibble << ( (n & 1) * 4 );
+		n++;
+	}
+
+	packed->castling = (uint16_t) pos->castling;
+	packed->enpassant = (int8_t) pos->enpassant;
+	packed->tomove = (uint8_t) pos->tomove;
+	packed->halfmove = (uint8_t) ( pos->halfmove > 255 ? 255 : pos->halfmove );
+	packed->fullmove = (uint16_t) pos->fullmove;
+
+	return true;
+}
+
+void chesspack_unpack( const PackedPosition* packed, Position* pos )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( packed != NULL );
+
+	memset( pos, 0, sizeof(Position) );
+
+	Bitboard occupied = packed->occupied;
+	int n = 0;
+	while ( occupied != BB_EMPTY ) {
+		int sq = bb_pop_first( &occupied );
+		int nibble = ( packed->pieces[ n >> 1 ] >> ( (n & 1) * 4 ) ) & 0x0f;
+		pos->board[ sq ] = CHESS_PIECES[ nibble - 1 ];
+		n++;
+	}
+
+	pos->castling = packed->castling;
+	pos->enpassant = packed->enpassant;
+	pos->tomove = (Color) packed->tomove;
+	pos->halfmove = packed->halfmove;
+	pos->fullmove = packed->fullmove;
+
+	chess_setup_position( pos );
+}
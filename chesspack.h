@@ -0,0 +1,42 @@
+#ifndef __chesspack_h__
+#define __chesspack_h__
+
+#include "chess.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* pieces a PackedPosition has room for, as many as a legal game can have */
+#define CHESSPACK_MAX_PIECES 32
+
+/* compact position for bulk storage, 32 bytes instead of sizeof(Position) */
+typedef struct
+{
+	/* squares with a piece on them */
+	uint64_t occupied;
+
+	/* one nibble per occupied square in square order, low nibble first, */
+	/* value is chess_piece_index() + 1 */
+	uint8_t pieces[16];
+
+	/* rook file flags as Position.castling */
+	uint16_t castling;
+	int8_t enpassant;
+	uint8_t tomove;
+
+	/* clamped at 255, more than enough for the 50 move rule */
+	uint8_t halfmove;
+
+	uint8_t unused;
+
+	uint16_t fullmove;
+} PackedPosition;
+
+/* false for a position with more than CHESSPACK_MAX_PIECES pieces, which */
+/* only a hand written FEN can give, packed is then left empty */
+bool chesspack_pack( const Position* pos, PackedPosition* packed );
+
+/* the complete Position again, bitboards, hash and attacks included */
+void chesspack_unpack( const PackedPosition* packed, Position* pos );
+
+#endif /* __chesspack_h__ */
@@ -0,0 +1,48 @@
+#ifndef __chesstables_h__
+#define __chesstables_h__
+
+#include "defs.h"
+#include "bitboard.h"
+
+#include <stdint.h>
+
+/* tables are generated at build time by chessgen, see Makefile */
+
+extern const Bitboard chess_knight_attacks[ CW_NB_OF_SQUARES ];
+extern const Bitboard chess_king_attacks[ CW_NB_OF_SQUARES ];
+
+/* squares attacked by a pawn on a square, indexed by Color */
+extern const Bitboard chess_pawn_attacks[ 2 ][ CW_NB_OF_SQUARES ];
+
+/* rook and bishop attacks on an empty board */
+extern const Bitboard chess_rook_rays[ CW_NB_OF_SQUARES ];
+extern const Bitboard chess_bishop_rays[ CW_NB_OF_SQUARES ];
+
+/* rays on an empty board by direction: north, north-east, east, */
+/* north-west (towards higher squares), then south, south-west, west, */
+/* south-east (towards lower squares) */
+#define CHESS_RAY_NORTH 0
+#define CHESS_RAY_NORTH_EAST 1
+#define CHESS_RAY_EAST 2
+#define CHESS_RAY_NORTH_WEST 3
+#define CHESS_RAY_SOUTH 4
+#define CHESS_RAY_SOUTH_WEST 5
+#define CHESS_RAY_WEST 6
+#define CHESS_RAY_SOUTH_EAST 7
+extern const Bitboard chess_rays[ 8 ][ CW_NB_OF_SQUARES ];
+
+/* squares strictly between two squares on a common rank, file or diagonal, */
+/* empty if not on a common line */
+extern const Bitboard chess_between[ CW_NB_OF_SQUARES ][ CW_NB_OF_SQUARES ];
+
+/* the whole line (edge to edge) through two squares, empty if not on a common line */
+extern const Bitboard chess_line[ CW_NB_OF_SQUARES ][ CW_NB_OF_SQUARES ];
+
+/* zobrist keys, pieces indexed as Position.pieces, castling one key per */
+/* CHESS_CASTLE_* rook file bit and en passant by file of the en passant square */
+extern const uint64_t chess_zobrist_pieces[ CW_NB_OF_PIECES ][ CW_NB_OF_SQUARES ];
+extern const uint64_t chess_zobrist_castling[ 16 ];
+extern const uint64_t chess_zobrist_enpassant[ CW_NB_OF_FILES ];
+extern const uint64_t chess_zobrist_black;
+
+#endif /* __chesstables_h__ */
@@ -13,7 +13,12 @@ typedef enum
 	CMD_LINE_PARSE_PGN_FILE,
 	CMD_LINE_PARSE_MOVE_SPEED,
 	CMD_LINE_PARSE_ENGINE,
-	CMD_LINE_PARSE_ENGINE_TIME_PERCENTAGE
+	CMD_LINE_PARSE_ENGINE_TIME_PERCENTAGE,
+	CMD_LINE_PARSE_SYZYGY_PATH,
+	CMD_LINE_PARSE_CACHE_DEPTH,
+	CMD_LINE_PARSE_ENGINE_COUNT,
+	CMD_LINE_PARSE_ENGINE_OPTION,
+	CMD_LINE_PARSE_BOOK
 } CmdLineParseState;
 
 /**********************************************************************/
@@ -49,10 +54,34 @@ bool cmdline_parse( int argc, char* argv[], CmdLineOptions* options )
 				strcmp( argv[i], "-t" ) == 0 ) {
 
 				state = CMD_LINE_PARSE_ENGINE_TIME_PERCENTAGE;
+			} else if ( strcmp( argv[i], "--syzygy-path" ) == 0 ||
+				strcmp( argv[i], "-y" ) == 0 ) {
+
+				state = CMD_LINE_PARSE_SYZYGY_PATH;
+			} else if ( strcmp( argv[i], "--cache-depth" ) == 0 ||
+				strcmp( argv[i], "-d" ) == 0 ) {
+
+				state = CMD_LINE_PARSE_CACHE_DEPTH;
+			} else if ( strcmp( argv[i], "--engines" ) == 0 ||
+				strcmp( argv[i], "-n" ) == 0 ) {
+
+				state = CMD_LINE_PARSE_ENGINE_COUNT;
+			} else if ( strcmp( argv[i], "--engine-option" ) == 0 ||
+				strcmp( argv[i], "-o" ) == 0 ) {
+
+				state = CMD_LINE_PARSE_ENGINE_OPTION;
+			} else if ( strcmp( argv[i], "--book" ) == 0 ||
+				strcmp( argv[i], "-b" ) == 0 ) {
+
+				state = CMD_LINE_PARSE_BOOK;
 			} else if ( strcmp( argv[i], "--random-order" ) == 0 ||
 				strcmp( argv[i], "-r" ) == 0 ) {
 
 				options->random_order = true;
+			} else if ( strcmp( argv[i], "--position-fen" ) == 0 ||
+				strcmp( argv[i], "-p" ) == 0 ) {
+
+				options->position_fen = true;
 			} else {
 				return false;
 			}
@@ -77,6 +106,35 @@ bool cmdline_parse( int argc, char* argv[], CmdLineOptions* options )
 			options->enginetime_percentage = argv[ i ];
 			state = CMD_LINE_PARSE_IDLE;
 			break;
+
+		case CMD_LINE_PARSE_SYZYGY_PATH:
+			options->syzygy_path = argv[ i ];
+			state = CMD_LINE_PARSE_IDLE;
+			break;
+
+		case CMD_LINE_PARSE_CACHE_DEPTH:
+			options->cache_depth = argv[ i ];
+			state = CMD_LINE_PARSE_IDLE;
+			break;
+
+		case CMD_LINE_PARSE_ENGINE_COUNT:
+			options->engine_count = argv[ i ];
+			state = CMD_LINE_PARSE_IDLE;
+			break;
+
+		case CMD_LINE_PARSE_ENGINE_OPTION:
+			if ( options->nbofengineoptions < CMDLINE_MAX_ENGINE_OPTIONS ) {
+				options->engine_options[ options->nbofengineoptions++ ] = argv[ i ];
+			} else {
+				LOG( WARNING, "Too many engine options, %s left out", argv[ i ] );
+			}
+			state = CMD_LINE_PARSE_IDLE;
+			break;
+
+		case CMD_LINE_PARSE_BOOK:
+			options->book = argv[ i ];
+			state = CMD_LINE_PARSE_IDLE;
+			break;
 		}
 	}
 
@@ -5,13 +5,24 @@
 #include <stdbool.h>
 
 
+/* --engine-option may be given this often */
+#define CMDLINE_MAX_ENGINE_OPTIONS 16
+
 typedef struct
 {
 	const char* pgnfile;
 	const char* engine;
 	const char* movespeed_s;
 	const char* enginetime_percentage;
+	const char* syzygy_path;
+	const char* cache_depth;
+	const char* engine_count;
+	const char* book;
+	/* "Name=Value" */
+	const char* engine_options[ CMDLINE_MAX_ENGINE_OPTIONS ];
+	int nbofengineoptions;
 	bool random_order;
+	bool position_fen;
 } CmdLineOptions;
 
 
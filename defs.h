@@ -7,6 +7,9 @@
 
 #define CW_NO_PIECE '\0'
 
+/* white and black pawn, knight, bishop, rook, queen and king */
+#define CW_NB_OF_PIECES 12
+
 /* max string length for a pgn move, inkl. null term. */
 /* ex. Qa5xd4+ */
 #define CW_MAX_MOVE_STRING 8
@@ -15,4 +18,7 @@
 /* ex. a7a8Q */
 #define CW_MAX_LONG_ALGEBRAIC_STRING 6
 
+/* max string length for a FEN, inkl. null term. */
+#define CW_MAX_FEN_STRING 92
+
 #endif /* __defs_h__ */
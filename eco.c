@@ -1,20 +1,40 @@
 #include "eco.h"
 #include "ecodb.h"
+#include "ecotables.h"
 #include "log.h"
+#include "dbgutil.h"
 
 #include <string.h>
+#include <ctype.h>
 
 /******************************************************************/
 
 const char* eco_name( const char* code )
 {
-	/* todo: bsearch() */
-	for ( int i = 0; i < ecodb_cnt(); ++i ) {
+	/* letter A to E and two digits, anything else is not a known code */
+	if ( code[ 0 ] < 'A' || code[ 0 ] > 'E' || !isdigit( (unsigned char) code[ 1 ] )
+			|| !isdigit( (unsigned char) code[ 2 ] ) || code[ 3 ] != '\0' ) {
+		return NULL;
+	}
+
+	int index = ( code[ 0 ] - 'A' ) * 100 + ( code[ 1 ] - '0' ) * 10 + ( code[ 2 ] - '0' );
+
+	const EcoDbRecord* e = ecodb_get( index );
+	dbgutil_test( strcmp( code, e->eco ) == 0 );
+
+	return e->name;
+}
+
+const char* eco_classify( uint64_t hash )
+{
+	int slot = (int) ( hash & ( ECO_POSITIONS_SIZE - 1 ) );
 
-		const EcoDbRecord* e = ecodb_get( i );
-		if ( strcmp( code, e->eco ) == 0 ) {
-			return e->name;
+	/* table is at most half full, probing ends at an empty slot */
+	while ( eco_positions[ slot ].hash != 0 ) {
+		if ( eco_positions[ slot ].hash == hash ) {
+			return eco_positions[ slot ].eco;
 		}
+		slot = ( slot + 1 ) & ( ECO_POSITIONS_SIZE - 1 );
 	}
 
 	return NULL;
@@ -1,8 +1,13 @@
 #ifndef __eco_h__
 #define __eco_h__
 
+#include <stdint.h>
 
 const char* eco_name( const char* code );
 
+/* ECO code of the opening position with this hash, NULL if the position */
+/* is not in the opening table */
+const char* eco_classify( uint64_t hash );
+
 
 #endif /* __eco_h__ */
@@ -3,7 +3,7 @@
 
 /******************************************************************/
 
-EcoDbRecord ecodb_data[] =
+const EcoDbRecord ecodb_data[] =
 {
 	{ "A00", "Irregular Opening" },
 	{ "A01", "Larsen's Opening, 1. b3" },
@@ -507,6 +507,9 @@ EcoDbRecord ecodb_data[] =
 	{ "E99", "King's Indian, Orthodox, Aronin-Taimanov, Main" }
 };
 
+_Static_assert( sizeof( ecodb_data ) / sizeof( EcoDbRecord ) == ECODB_NB_OF_CODES,
+		"ecodb_data should have one record per ECO code" );
+
 /******************************************************************/
 
 int ecodb_cnt()
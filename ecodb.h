@@ -10,6 +10,10 @@ typedef struct {
 	const char* name;
 } EcoDbRecord;
 
+/* one record per code A00 to E99, in order, so the record for a code */
+/* is at ( letter - 'A' ) * 100 + number */
+#define ECODB_NB_OF_CODES 500
+
 
 int ecodb_cnt();
 const EcoDbRecord* ecodb_get( int index );
@@ -0,0 +1,743 @@
+/* build time generator for the opening position table in ecotables.c */
+/* usage: ecogen > ecotables.c */
+
+#include "chess.h"
+#include "ecotables.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/************************************************************************/
+
+typedef struct
+{
+	const char* eco;
+
+	/* moves in SAN, no move numbers */
+	const char* moves;
+} EcoGenLine;
+
+/* main line of (most) ECO codes, a position is named after the line */
+/* ending in it, so transpositions end up with the same code */
+static const EcoGenLine ecogen_lines[] =
+{
+	{ "A00", "g4" },
+	{ "A00", "Nc3" },
+	{ "A00", "b4" },
+	{ "A00", "g3" },
+	{ "A00", "e3" },
+	{ "A00", "d3" },
+	{ "A00", "c3" },
+	{ "A00", "a3" },
+	{ "A00", "h3" },
+	{ "A00", "Nh3" },
+	{ "A00", "f3" },
+	{ "A00", "a4" },
+	{ "A00", "h4" },
+	{ "A00", "Na3" },
+	{ "A01", "b3" },
+	{ "A02", "f4" },
+	{ "A03", "f4 d5" },
+	{ "A04", "Nf3" },
+	{ "A05", "Nf3 Nf6" },
+	{ "A06", "Nf3 d5" },
+	{ "A07", "Nf3 d5 g3" },
+	{ "A08", "Nf3 d5 g3 c5 Bg2" },
+	{ "A09", "Nf3 d5 c4" },
+	{ "A10", "c4" },
+	{ "A11", "c4 c6" },
+	{ "A12", "c4 c6 Nf3 d5 b3" },
+	{ "A13", "c4 e6" },
+	{ "A14", "c4 e6 Nf3 d5 g3 Nf6 Bg2 Be7 O-O" },
+	{ "A15", "c4 Nf6" },
+	{ "A16", "c4 Nf6 Nc3" },
+	{ "A17", "c4 Nf6 Nc3 e6" },
+	{ "A18", "c4 Nf6 Nc3 e6 e4" },
+	{ "A19", "c4 Nf6 Nc3 e6 e4 c5" },
+	{ "A20", "c4 e5" },
+	{ "A21", "c4 e5 Nc3" },
+	{ "A22", "c4 e5 Nc3 Nf6" },
+	{ "A23", "c4 e5 Nc3 Nf6 g3 c6" },
+	{ "A24", "c4 e5 Nc3 Nf6 g3 g6" },
+	{ "A25", "c4 e5 Nc3 Nc6" },
+	{ "A26", "c4 e5 Nc3 Nc6 g3 g6 Bg2 Bg7 d3 d6" },
+	{ "A27", "c4 e5 Nc3 Nc6 Nf3" },
+	{ "A28", "c4 e5 Nc3 Nc6 Nf3 Nf6" },
+	{ "A29", "c4 e5 Nc3 Nc6 Nf3 Nf6 g3" },
+	{ "A30", "c4 c5" },
+	{ "A31", "c4 c5 Nf3 Nf6 d4" },
+	{ "A32", "c4 c5 Nf3 Nf6 d4 cxd4 Nxd4 e6" },
+	{ "A33", "c4 c5 Nf3 Nf6 d4 cxd4 Nxd4 e6 Nc3 Nc6" },
+	{ "A34", "c4 c5 Nc3" },
+	{ "A35", "c4 c5 Nc3 Nc6" },
+	{ "A36", "c4 c5 Nc3 Nc6 g3" },
+	{ "A37", "c4 c5 Nc3 Nc6 g3 g6 Bg2 Bg7 Nf3" },
+	{ "A38", "c4 c5 Nc3 Nc6 g3 g6 Bg2 Bg7 Nf3 Nf6" },
+	{ "A39", "c4 c5 Nc3 Nc6 g3 g6 Bg2 Bg7 Nf3 Nf6 O-O O-O d4" },
+	{ "A40", "d4" },
+	{ "A40", "d4 e6" },
+	{ "A40", "d4 b6" },
+	{ "A40", "d4 Nc6" },
+	{ "A40", "d4 e5" },
+	{ "A41", "d4 d6" },
+	{ "A42", "d4 d6 c4 g6 Nc3 Bg7 e4" },
+	{ "A43", "d4 c5" },
+	{ "A44", "d4 c5 d5 e5" },
+	{ "A45", "d4 Nf6" },
+	{ "A45", "d4 Nf6 Bg5" },
+	{ "A46", "d4 Nf6 Nf3" },
+	{ "A46", "d4 Nf6 Nf3 e6" },
+	{ "A47", "d4 Nf6 Nf3 b6" },
+	{ "A48", "d4 Nf6 Nf3 g6" },
+	{ "A49", "d4 Nf6 Nf3 g6 g3" },
+	{ "A50", "d4 Nf6 c4" },
+	{ "A50", "d4 Nf6 c4 Nc6" },
+	{ "A51", "d4 Nf6 c4 e5" },
+	{ "A52", "d4 Nf6 c4 e5 dxe5 Ng4" },
+	{ "A53", "d4 Nf6 c4 d6" },
+	{ "A54", "d4 Nf6 c4 d6 Nc3 e5 e3 Nbd7" },
+	{ "A55", "d4 Nf6 c4 d6 Nc3 e5 Nf3 Nbd7 e4" },
+	{ "A56", "d4 Nf6 c4 c5" },
+	{ "A56", "d4 Nf6 c4 c5 d5 e5" },
+	{ "A57", "d4 Nf6 c4 c5 d5 b5" },
+	{ "A58", "d4 Nf6 c4 c5 d5 b5 cxb5 a6 bxa6" },
+	{ "A59", "d4 Nf6 c4 c5 d5 b5 cxb5 a6 bxa6 Bxa6 Nc3 d6 e4" },
+	{ "A60", "d4 Nf6 c4 c5 d5 e6" },
+	{ "A61", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 Nf3 g6" },
+	{ "A62", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 Nf3 g6 g3 Bg7 Bg2 O-O" },
+	{ "A65", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4" },
+	{ "A66", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 f4" },
+	{ "A67", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 f4 Bg7 Bb5+" },
+	{ "A68", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 f4 Bg7 Nf3 O-O" },
+	{ "A69", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 f4 Bg7 Nf3 O-O Be2 Re8" },
+	{ "A70", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 Nf3" },
+	{ "A71", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 Nf3 Bg7 Bg5" },
+	{ "A72", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 Nf3 Bg7 Be2 O-O" },
+	{ "A73", "d4 Nf6 c4 c5 d5 e6 Nc3 exd5 cxd5 d6 e4 g6 Nf3 Bg7 Be2 O-O O-O" },
+	{ "A80", "d4 f5" },
+	{ "A81", "d4 f5 g3" },
+	{ "A82", "d4 f5 e4" },
+	{ "A83", "d4 f5 e4 fxe4 Nc3 Nf6 Bg5" },
+	{ "A84", "d4 f5 c4" },
+	{ "A85", "d4 f5 c4 Nf6 Nc3" },
+	{ "A86", "d4 f5 c4 Nf6 g3" },
+	{ "A87", "d4 f5 c4 Nf6 g3 g6 Bg2 Bg7 Nf3" },
+	{ "A90", "d4 f5 c4 Nf6 g3 e6 Bg2" },
+	{ "A91", "d4 f5 c4 Nf6 g3 e6 Bg2 Be7" },
+	{ "A92", "d4 f5 c4 Nf6 g3 e6 Bg2 Be7 Nf3 O-O" },
+	{ "A96", "d4 f5 c4 Nf6 g3 e6 Bg2 Be7 Nf3 O-O O-O d6" },
+	{ "A97", "d4 f5 c4 Nf6 g3 e6 Bg2 Be7 Nf3 O-O O-O d6 Nc3 Qe8" },
+
+	{ "B00", "e4" },
+	{ "B00", "e4 Nc6" },
+	{ "B00", "e4 b6" },
+	{ "B00", "e4 a6" },
+	{ "B01", "e4 d5" },
+	{ "B02", "e4 Nf6" },
+	{ "B03", "e4 Nf6 e5 Nd5 d4" },
+	{ "B04", "e4 Nf6 e5 Nd5 d4 d6 Nf3" },
+	{ "B05", "e4 Nf6 e5 Nd5 d4 d6 Nf3 Bg4" },
+	{ "B06", "e4 g6" },
+	{ "B07", "e4 d6" },
+	{ "B07", "e4 d6 d4 Nf6" },
+	{ "B08", "e4 d6 d4 Nf6 Nc3 g6 Nf3" },
+	{ "B09", "e4 d6 d4 Nf6 Nc3 g6 f4" },
+	{ "B10", "e4 c6" },
+	{ "B11", "e4 c6 Nc3 d5 Nf3 Bg4" },
+	{ "B12", "e4 c6 d4 d5" },
+	{ "B12", "e4 c6 d4 d5 e5" },
+	{ "B13", "e4 c6 d4 d5 exd5 cxd5" },
+	{ "B14", "e4 c6 d4 d5 exd5 cxd5 c4 Nf6 Nc3 e6" },
+	{ "B15", "e4 c6 d4 d5 Nc3" },
+	{ "B15", "e4 c6 d4 d5 Nd2" },
+	{ "B15", "e4 c6 d4 d5 Nc3 dxe4 Nxe4" },
+	{ "B16", "e4 c6 d4 d5 Nc3 dxe4 Nxe4 Nf6 Nxf6+ gxf6" },
+	{ "B17", "e4 c6 d4 d5 Nc3 dxe4 Nxe4 Nd7" },
+	{ "B18", "e4 c6 d4 d5 Nc3 dxe4 Nxe4 Bf5" },
+	{ "B19", "e4 c6 d4 d5 Nc3 dxe4 Nxe4 Bf5 Ng3 Bg6 h4 h6 Nf3 Nd7" },
+	{ "B20", "e4 c5" },
+	{ "B21", "e4 c5 f4" },
+	{ "B21", "e4 c5 d4 cxd4 c3" },
+	{ "B22", "e4 c5 c3" },
+	{ "B23", "e4 c5 Nc3" },
+	{ "B24", "e4 c5 Nc3 Nc6 g3" },
+	{ "B25", "e4 c5 Nc3 Nc6 g3 g6 Bg2 Bg7 d3 d6" },
+	{ "B26", "e4 c5 Nc3 Nc6 g3 g6 Bg2 Bg7 d3 d6 Be3" },
+	{ "B27", "e4 c5 Nf3" },
+	{ "B27", "e4 c5 Nf3 g6" },
+	{ "B28", "e4 c5 Nf3 a6" },
+	{ "B29", "e4 c5 Nf3 Nf6" },
+	{ "B30", "e4 c5 Nf3 Nc6" },
+	{ "B30", "e4 c5 Nf3 Nc6 Bb5" },
+	{ "B31", "e4 c5 Nf3 Nc6 Bb5 g6" },
+	{ "B32", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4" },
+	{ "B32", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 e5" },
+	{ "B33", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 Nf6" },
+	{ "B33", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 Nf6 Nc3 e5" },
+	{ "B34", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6" },
+	{ "B34", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 Nxc6" },
+	{ "B35", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 Nc3 Bg7 Be3 Nf6 Bc4" },
+	{ "B36", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 c4" },
+	{ "B37", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 c4 Bg7" },
+	{ "B38", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 c4 Bg7 Be3" },
+	{ "B39", "e4 c5 Nf3 Nc6 d4 cxd4 Nxd4 g6 c4 Bg7 Be3 Nf6 Nc3 Ng4" },
+	{ "B40", "e4 c5 Nf3 e6" },
+	{ "B40", "e4 c5 Nf3 e6 d4 cxd4 Nxd4" },
+	{ "B41", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 a6" },
+	{ "B42", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 a6 Bd3" },
+	{ "B43", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 a6 Nc3" },
+	{ "B44", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6" },
+	{ "B45", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6 Nc3" },
+	{ "B46", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6 Nc3 a6" },
+	{ "B47", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6 Nc3 Qc7" },
+	{ "B48", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6 Nc3 Qc7 Be3" },
+	{ "B49", "e4 c5 Nf3 e6 d4 cxd4 Nxd4 Nc6 Nc3 Qc7 Be3 a6 Be2" },
+	{ "B50", "e4 c5 Nf3 d6" },
+	{ "B51", "e4 c5 Nf3 d6 Bb5+" },
+	{ "B52", "e4 c5 Nf3 d6 Bb5+ Bd7" },
+	{ "B53", "e4 c5 Nf3 d6 d4 cxd4 Qxd4" },
+	{ "B54", "e4 c5 Nf3 d6 d4 cxd4 Nxd4" },
+	{ "B54", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6" },
+	{ "B55", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 f3 e5 Bb5+" },
+	{ "B56", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3" },
+	{ "B56", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6" },
+	{ "B57", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bc4" },
+	{ "B58", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Be2" },
+	{ "B59", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Be2 e5 Nb3" },
+	{ "B60", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bg5" },
+	{ "B61", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bg5 Bd7 Qd2" },
+	{ "B62", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bg5 e6" },
+	{ "B63", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bg5 e6 Qd2" },
+	{ "B66", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 Nc6 Bg5 e6 Qd2 a6" },
+	{ "B70", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6" },
+	{ "B71", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 f4" },
+	{ "B72", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3" },
+	{ "B73", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3 Bg7 Be2 Nc6 O-O" },
+	{ "B75", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3 Bg7 f3" },
+	{ "B76", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3 Bg7 f3 O-O" },
+	{ "B77", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3 Bg7 f3 O-O Qd2 Nc6 Bc4" },
+	{ "B78", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 g6 Be3 Bg7 f3 O-O Qd2 Nc6 Bc4 Bd7 O-O-O" },
+	{ "B80", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6" },
+	{ "B81", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6 g4" },
+	{ "B82", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6 f4" },
+	{ "B83", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6 Be2" },
+	{ "B86", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6 Bc4" },
+	{ "B87", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 e6 Bc4 a6 Bb3 b5" },
+	{ "B90", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6" },
+	{ "B90", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Be3" },
+	{ "B91", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 g3" },
+	{ "B92", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Be2" },
+	{ "B93", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 f4" },
+	{ "B94", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5" },
+	{ "B95", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5 e6" },
+	{ "B96", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5 e6 f4" },
+	{ "B97", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5 e6 f4 Qb6" },
+	{ "B98", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5 e6 f4 Be7" },
+	{ "B99", "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6 Bg5 e6 f4 Be7 Qf3 Qc7 O-O-O Nbd7" },
+
+	{ "C00", "e4 e6" },
+	{ "C00", "e4 e6 d3" },
+	{ "C00", "e4 e6 d4 d5" },
+	{ "C01", "e4 e6 d4 d5 exd5" },
+	{ "C01", "e4 e6 d4 d5 exd5 exd5" },
+	{ "C02", "e4 e6 d4 d5 e5" },
+	{ "C02", "e4 e6 d4 d5 e5 c5 c3" },
+	{ "C03", "e4 e6 d4 d5 Nd2" },
+	{ "C04", "e4 e6 d4 d5 Nd2 Nc6 Ngf3 Nf6" },
+	{ "C05", "e4 e6 d4 d5 Nd2 Nf6" },
+	{ "C05", "e4 e6 d4 d5 Nd2 Nf6 e5 Nfd7" },
+	{ "C06", "e4 e6 d4 d5 Nd2 Nf6 e5 Nfd7 Bd3 c5 c3 Nc6 Ne2" },
+	{ "C07", "e4 e6 d4 d5 Nd2 c5" },
+	{ "C08", "e4 e6 d4 d5 Nd2 c5 exd5 exd5" },
+	{ "C09", "e4 e6 d4 d5 Nd2 c5 exd5 exd5 Ngf3 Nc6" },
+	{ "C10", "e4 e6 d4 d5 Nc3" },
+	{ "C10", "e4 e6 d4 d5 Nc3 dxe4" },
+	{ "C11", "e4 e6 d4 d5 Nc3 Nf6" },
+	{ "C11", "e4 e6 d4 d5 Nc3 Nf6 e5 Nfd7" },
+	{ "C12", "e4 e6 d4 d5 Nc3 Nf6 Bg5 Bb4" },
+	{ "C13", "e4 e6 d4 d5 Nc3 Nf6 Bg5 Be7" },
+	{ "C13", "e4 e6 d4 d5 Nc3 Nf6 Bg5 dxe4" },
+	{ "C14", "e4 e6 d4 d5 Nc3 Nf6 Bg5 Be7 e5 Nfd7 Bxe7 Qxe7" },
+	{ "C15", "e4 e6 d4 d5 Nc3 Bb4" },
+	{ "C16", "e4 e6 d4 d5 Nc3 Bb4 e5" },
+	{ "C17", "e4 e6 d4 d5 Nc3 Bb4 e5 c5" },
+	{ "C18", "e4 e6 d4 d5 Nc3 Bb4 e5 c5 a3 Bxc3+ bxc3" },
+	{ "C19", "e4 e6 d4 d5 Nc3 Bb4 e5 c5 a3 Bxc3+ bxc3 Ne7" },
+	{ "C20", "e4 e5" },
+	{ "C20", "e4 e5 d3" },
+	{ "C20", "e4 e5 c3" },
+	{ "C20", "e4 e5 Qh5" },
+	{ "C21", "e4 e5 d4 exd4" },
+	{ "C21", "e4 e5 d4 exd4 c3" },
+	{ "C22", "e4 e5 d4 exd4 Qxd4 Nc6" },
+	{ "C23", "e4 e5 Bc4" },
+	{ "C24", "e4 e5 Bc4 Nf6" },
+	{ "C25", "e4 e5 Nc3" },
+	{ "C25", "e4 e5 Nc3 Nc6" },
+	{ "C26", "e4 e5 Nc3 Nf6" },
+	{ "C27", "e4 e5 Nc3 Nf6 Bc4 Nxe4" },
+	{ "C28", "e4 e5 Nc3 Nf6 Bc4 Nc6" },
+	{ "C29", "e4 e5 Nc3 Nf6 f4 d5" },
+	{ "C30", "e4 e5 f4" },
+	{ "C30", "e4 e5 f4 Bc5" },
+	{ "C31", "e4 e5 f4 d5" },
+	{ "C32", "e4 e5 f4 d5 exd5 e4 d3 Nf6 dxe4" },
+	{ "C33", "e4 e5 f4 exf4" },
+	{ "C33", "e4 e5 f4 exf4 Bc4" },
+	{ "C34", "e4 e5 f4 exf4 Nf3" },
+	{ "C34", "e4 e5 f4 exf4 Nf3 d6" },
+	{ "C35", "e4 e5 f4 exf4 Nf3 Be7" },
+	{ "C36", "e4 e5 f4 exf4 Nf3 d5" },
+	{ "C37", "e4 e5 f4 exf4 Nf3 g5 Nc3" },
+	{ "C38", "e4 e5 f4 exf4 Nf3 g5 Bc4 Bg7" },
+	{ "C39", "e4 e5 f4 exf4 Nf3 g5 h4" },
+	{ "C40", "e4 e5 Nf3" },
+	{ "C40", "e4 e5 Nf3 f5" },
+	{ "C40", "e4 e5 Nf3 d5" },
+	{ "C41", "e4 e5 Nf3 d6" },
+	{ "C41", "e4 e5 Nf3 d6 d4" },
+	{ "C42", "e4 e5 Nf3 Nf6" },
+	{ "C42", "e4 e5 Nf3 Nf6 Nxe5 d6 Nf3 Nxe4" },
+	{ "C43", "e4 e5 Nf3 Nf6 d4" },
+	{ "C44", "e4 e5 Nf3 Nc6" },
+	{ "C44", "e4 e5 Nf3 Nc6 c3" },
+	{ "C44", "e4 e5 Nf3 Nc6 d4" },
+	{ "C44", "e4 e5 Nf3 Nc6 d4 exd4" },
+	{ "C44", "e4 e5 Nf3 Nc6 d4 exd4 Bc4" },
+	{ "C45", "e4 e5 Nf3 Nc6 d4 exd4 Nxd4" },
+	{ "C45", "e4 e5 Nf3 Nc6 d4 exd4 Nxd4 Nf6" },
+	{ "C45", "e4 e5 Nf3 Nc6 d4 exd4 Nxd4 Bc5" },
+	{ "C46", "e4 e5 Nf3 Nc6 Nc3" },
+	{ "C47", "e4 e5 Nf3 Nc6 Nc3 Nf6" },
+	{ "C47", "e4 e5 Nf3 Nc6 Nc3 Nf6 d4" },
+	{ "C48", "e4 e5 Nf3 Nc6 Nc3 Nf6 Bb5" },
+	{ "C49", "e4 e5 Nf3 Nc6 Nc3 Nf6 Bb5 Bb4" },
+	{ "C50", "e4 e5 Nf3 Nc6 Bc4" },
+	{ "C50", "e4 e5 Nf3 Nc6 Bc4 Bc5" },
+	{ "C50", "e4 e5 Nf3 Nc6 Bc4 Be7" },
+	{ "C50", "e4 e5 Nf3 Nc6 Bc4 Bc5 d3" },
+	{ "C51", "e4 e5 Nf3 Nc6 Bc4 Bc5 b4" },
+	{ "C52", "e4 e5 Nf3 Nc6 Bc4 Bc5 b4 Bxb4 c3 Ba5" },
+	{ "C53", "e4 e5 Nf3 Nc6 Bc4 Bc5 c3" },
+	{ "C53", "e4 e5 Nf3 Nc6 Bc4 Bc5 c3 Nf6" },
+	{ "C54", "e4 e5 Nf3 Nc6 Bc4 Bc5 c3 Nf6 d4 exd4 cxd4" },
+	{ "C54", "e4 e5 Nf3 Nc6 Bc4 Bc5 c3 Nf6 d3" },
+	{ "C55", "e4 e5 Nf3 Nc6 Bc4 Nf6" },
+	{ "C55", "e4 e5 Nf3 Nc6 Bc4 Nf6 d3" },
+	{ "C55", "e4 e5 Nf3 Nc6 Bc4 Nf6 d4 exd4 O-O" },
+	{ "C56", "e4 e5 Nf3 Nc6 Bc4 Nf6 d4 exd4 O-O Nxe4" },
+	{ "C57", "e4 e5 Nf3 Nc6 Bc4 Nf6 Ng5" },
+	{ "C58", "e4 e5 Nf3 Nc6 Bc4 Nf6 Ng5 d5 exd5 Na5" },
+	{ "C59", "e4 e5 Nf3 Nc6 Bc4 Nf6 Ng5 d5 exd5 Na5 Bb5+ c6 dxc6 bxc6 Be2 h6" },
+	{ "C60", "e4 e5 Nf3 Nc6 Bb5" },
+	{ "C60", "e4 e5 Nf3 Nc6 Bb5 g6" },
+	{ "C60", "e4 e5 Nf3 Nc6 Bb5 Nge7" },
+	{ "C61", "e4 e5 Nf3 Nc6 Bb5 Nd4" },
+	{ "C62", "e4 e5 Nf3 Nc6 Bb5 d6" },
+	{ "C63", "e4 e5 Nf3 Nc6 Bb5 f5" },
+	{ "C64", "e4 e5 Nf3 Nc6 Bb5 Bc5" },
+	{ "C65", "e4 e5 Nf3 Nc6 Bb5 Nf6" },
+	{ "C65", "e4 e5 Nf3 Nc6 Bb5 Nf6 d3" },
+	{ "C65", "e4 e5 Nf3 Nc6 Bb5 Nf6 O-O" },
+	{ "C66", "e4 e5 Nf3 Nc6 Bb5 Nf6 O-O d6" },
+	{ "C67", "e4 e5 Nf3 Nc6 Bb5 Nf6 O-O Nxe4" },
+	{ "C67", "e4 e5 Nf3 Nc6 Bb5 Nf6 O-O Nxe4 d4 Nd6 Bxc6 dxc6 dxe5 Nf5 Qxd8+ Kxd8" },
+	{ "C68", "e4 e5 Nf3 Nc6 Bb5 a6 Bxc6" },
+	{ "C68", "e4 e5 Nf3 Nc6 Bb5 a6 Bxc6 dxc6" },
+	{ "C69", "e4 e5 Nf3 Nc6 Bb5 a6 Bxc6 dxc6 O-O" },
+	{ "C70", "e4 e5 Nf3 Nc6 Bb5 a6" },
+	{ "C70", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4" },
+	{ "C71", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6" },
+	{ "C72", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6 O-O" },
+	{ "C73", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6 Bxc6+ bxc6 d4" },
+	{ "C74", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6 c3" },
+	{ "C75", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6 c3 Bd7" },
+	{ "C76", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 d6 c3 Bd7 d4 g6" },
+	{ "C77", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6" },
+	{ "C77", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 d3" },
+	{ "C78", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O" },
+	{ "C78", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O b5 Bb3 Bc5" },
+	{ "C79", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O d6" },
+	{ "C80", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Nxe4" },
+	{ "C80", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Nxe4 d4 b5 Bb3 d5 dxe5 Be6" },
+	{ "C81", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Nxe4 d4 b5 Bb3 d5 dxe5 Be6 Qe2" },
+	{ "C82", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Nxe4 d4 b5 Bb3 d5 dxe5 Be6 c3" },
+	{ "C83", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Nxe4 d4 b5 Bb3 d5 dxe5 Be6 c3 Be7" },
+	{ "C84", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7" },
+	{ "C84", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 d4" },
+	{ "C85", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Bxc6 dxc6" },
+	{ "C86", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Qe2" },
+	{ "C87", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 d6" },
+	{ "C88", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3" },
+	{ "C88", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 O-O" },
+	{ "C88", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 O-O c3" },
+	{ "C88", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 O-O h3" },
+	{ "C88", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 O-O a4" },
+	{ "C89", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 O-O c3 d5" },
+	{ "C90", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6" },
+	{ "C90", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3" },
+	{ "C90", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O" },
+	{ "C91", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O d4" },
+	{ "C92", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3" },
+	{ "C92", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Bb7" },
+	{ "C92", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Nd7" },
+	{ "C93", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 h6" },
+	{ "C94", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Nb8" },
+	{ "C95", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Nb8 d4" },
+	{ "C96", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Na5 Bc2" },
+	{ "C97", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Na5 Bc2 c5 d4 Qc7" },
+	{ "C98", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Na5 Bc2 c5 d4 Qc7 Nbd2 Nc6" },
+	{ "C99", "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Na5 Bc2 c5 d4 Qc7 Nbd2 cxd4 cxd4" },
+
+	{ "D00", "d4 d5" },
+	{ "D00", "d4 d5 e3" },
+	{ "D00", "d4 d5 Bf4" },
+	{ "D00", "d4 d5 e4" },
+	{ "D00", "d4 d5 Nc3" },
+	{ "D01", "d4 d5 Nc3 Nf6 Bg5" },
+	{ "D02", "d4 d5 Nf3" },
+	{ "D02", "d4 d5 Nf3 Nf6" },
+	{ "D02", "d4 d5 Nf3 Nf6 Bf4" },
+	{ "D03", "d4 d5 Nf3 Nf6 Bg5" },
+	{ "D04", "d4 d5 Nf3 Nf6 e3" },
+	{ "D05", "d4 d5 Nf3 Nf6 e3 e6" },
+	{ "D05", "d4 d5 Nf3 Nf6 e3 e6 Bd3" },
+	{ "D06", "d4 d5 c4" },
+	{ "D06", "d4 d5 c4 Bf5" },
+	{ "D06", "d4 d5 c4 c5" },
+	{ "D06", "d4 d5 c4 Nf6" },
+	{ "D07", "d4 d5 c4 Nc6" },
+	{ "D08", "d4 d5 c4 e5" },
+	{ "D08", "d4 d5 c4 e5 dxe5 d4" },
+	{ "D09", "d4 d5 c4 e5 dxe5 d4 Nf3 Nc6 g3" },
+	{ "D10", "d4 d5 c4 c6" },
+	{ "D10", "d4 d5 c4 c6 Nc3" },
+	{ "D10", "d4 d5 c4 c6 cxd5 cxd5" },
+	{ "D11", "d4 d5 c4 c6 Nf3" },
+	{ "D11", "d4 d5 c4 c6 Nf3 Nf6" },
+	{ "D11", "d4 d5 c4 c6 Nf3 Nf6 e3" },
+	{ "D12", "d4 d5 c4 c6 Nf3 Nf6 e3 Bf5" },
+	{ "D13", "d4 d5 c4 c6 Nf3 Nf6 cxd5 cxd5" },
+	{ "D14", "d4 d5 c4 c6 Nf3 Nf6 cxd5 cxd5 Nc3 Nc6 Bf4 Bf5" },
+	{ "D15", "d4 d5 c4 c6 Nf3 Nf6 Nc3" },
+	{ "D15", "d4 d5 c4 c6 Nf3 Nf6 Nc3 a6" },
+	{ "D15", "d4 d5 c4 c6 Nf3 Nf6 Nc3 dxc4" },
+	{ "D16", "d4 d5 c4 c6 Nf3 Nf6 Nc3 dxc4 a4" },
+	{ "D17", "d4 d5 c4 c6 Nf3 Nf6 Nc3 dxc4 a4 Bf5" },
+	{ "D18", "d4 d5 c4 c6 Nf3 Nf6 Nc3 dxc4 a4 Bf5 e3" },
+	{ "D19", "d4 d5 c4 c6 Nf3 Nf6 Nc3 dxc4 a4 Bf5 e3 e6 Bxc4 Bb4 O-O" },
+	{ "D20", "d4 d5 c4 dxc4" },
+	{ "D20", "d4 d5 c4 dxc4 e4" },
+	{ "D20", "d4 d5 c4 dxc4 e3" },
+	{ "D21", "d4 d5 c4 dxc4 Nf3" },
+	{ "D22", "d4 d5 c4 dxc4 Nf3 a6" },
+	{ "D23", "d4 d5 c4 dxc4 Nf3 Nf6" },
+	{ "D24", "d4 d5 c4 dxc4 Nf3 Nf6 Nc3" },
+	{ "D25", "d4 d5 c4 dxc4 Nf3 Nf6 e3" },
+	{ "D26", "d4 d5 c4 dxc4 Nf3 Nf6 e3 e6" },
+	{ "D26", "d4 d5 c4 dxc4 Nf3 Nf6 e3 e6 Bxc4 c5" },
+	{ "D27", "d4 d5 c4 dxc4 Nf3 Nf6 e3 e6 Bxc4 c5 O-O a6" },
+	{ "D28", "d4 d5 c4 dxc4 Nf3 Nf6 e3 e6 Bxc4 c5 O-O a6 Qe2" },
+	{ "D29", "d4 d5 c4 dxc4 Nf3 Nf6 e3 e6 Bxc4 c5 O-O a6 Qe2 b5 Bb3 Bb7" },
+	{ "D30", "d4 d5 c4 e6" },
+	{ "D30", "d4 d5 c4 e6 Nf3" },
+	{ "D30", "d4 d5 c4 e6 Nf3 Nf6" },
+	{ "D31", "d4 d5 c4 e6 Nc3" },
+	{ "D31", "d4 d5 c4 e6 Nc3 Be7" },
+	{ "D31", "d4 d5 c4 e6 Nc3 c6" },
+	{ "D32", "d4 d5 c4 e6 Nc3 c5" },
+	{ "D33", "d4 d5 c4 e6 Nc3 c5 cxd5 exd5 Nf3 Nc6 g3" },
+	{ "D34", "d4 d5 c4 e6 Nc3 c5 cxd5 exd5 Nf3 Nc6 g3 Nf6 Bg2 Be7" },
+	{ "D35", "d4 d5 c4 e6 Nc3 Nf6" },
+	{ "D35", "d4 d5 c4 e6 Nc3 Nf6 cxd5 exd5" },
+	{ "D35", "d4 d5 c4 e6 Nc3 Nf6 cxd5 exd5 Bg5" },
+	{ "D36", "d4 d5 c4 e6 Nc3 Nf6 cxd5 exd5 Bg5 c6 Qc2" },
+	{ "D37", "d4 d5 c4 e6 Nc3 Nf6 Nf3" },
+	{ "D37", "d4 d5 c4 e6 Nc3 Nf6 Nf3 Be7" },
+	{ "D37", "d4 d5 c4 e6 Nc3 Nf6 Nf3 Be7 Bf4" },
+	{ "D38", "d4 d5 c4 e6 Nc3 Nf6 Nf3 Bb4" },
+	{ "D39", "d4 d5 c4 e6 Nc3 Nf6 Nf3 Bb4 Bg5 dxc4" },
+	{ "D40", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c5" },
+	{ "D41", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c5 cxd5" },
+	{ "D41", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c5 cxd5 Nxd5" },
+	{ "D43", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6" },
+	{ "D43", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 Bg5" },
+	{ "D44", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 Bg5 dxc4" },
+	{ "D45", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3" },
+	{ "D45", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7" },
+	{ "D45", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Qc2" },
+	{ "D46", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Bd3" },
+	{ "D46", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Bd3 Bd6" },
+	{ "D47", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Bd3 dxc4 Bxc4" },
+	{ "D47", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Bd3 dxc4 Bxc4 b5 Bd3" },
+	{ "D48", "d4 d5 c4 e6 Nc3 Nf6 Nf3 c6 e3 Nbd7 Bd3 dxc4 Bxc4 b5 Bd3 a6" },
+	{ "D50", "d4 d5 c4 e6 Nc3 Nf6 Bg5" },
+	{ "D51", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Nbd7" },
+	{ "D52", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Nbd7 e3 c6 Nf3" },
+	{ "D52", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Nbd7 e3 c6 Nf3 Qa5" },
+	{ "D53", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7" },
+	{ "D53", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3" },
+	{ "D55", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3" },
+	{ "D56", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 h6 Bh4" },
+	{ "D56", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 h6 Bh4 Ne4" },
+	{ "D58", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 h6 Bh4 b6" },
+	{ "D60", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 Nbd7" },
+	{ "D61", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 Nbd7 Qc2" },
+	{ "D63", "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O Nf3 Nbd7 Rc1" },
+	{ "D70", "d4 Nf6 c4 g6 f3 d5" },
+	{ "D71", "d4 Nf6 c4 g6 g3 d5" },
+	{ "D71", "d4 Nf6 c4 g6 g3 d5 Bg2 Bg7 cxd5 Nxd5" },
+	{ "D73", "d4 Nf6 c4 g6 g3 d5 Bg2 Bg7 Nf3" },
+	{ "D77", "d4 Nf6 c4 g6 g3 d5 Bg2 Bg7 Nf3 O-O O-O" },
+	{ "D80", "d4 Nf6 c4 g6 Nc3 d5" },
+	{ "D81", "d4 Nf6 c4 g6 Nc3 d5 Qb3" },
+	{ "D82", "d4 Nf6 c4 g6 Nc3 d5 Bf4" },
+	{ "D85", "d4 Nf6 c4 g6 Nc3 d5 cxd5 Nxd5" },
+	{ "D85", "d4 Nf6 c4 g6 Nc3 d5 cxd5 Nxd5 e4 Nxc3 bxc3 Bg7" },
+	{ "D86", "d4 Nf6 c4 g6 Nc3 d5 cxd5 Nxd5 e4 Nxc3 bxc3 Bg7 Bc4" },
+	{ "D90", "d4 Nf6 c4 g6 Nc3 d5 Nf3" },
+	{ "D90", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7" },
+	{ "D91", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7 Bg5" },
+	{ "D92", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7 Bf4" },
+	{ "D94", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7 e3" },
+	{ "D96", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7 Qb3" },
+	{ "D97", "d4 Nf6 c4 g6 Nc3 d5 Nf3 Bg7 Qb3 dxc4 Qxc4 O-O e4" },
+
+	{ "E00", "d4 Nf6 c4 e6" },
+	{ "E00", "d4 Nf6 c4 e6 g3" },
+	{ "E01", "d4 Nf6 c4 e6 g3 d5 Bg2" },
+	{ "E02", "d4 Nf6 c4 e6 g3 d5 Bg2 dxc4 Qa4+" },
+	{ "E04", "d4 Nf6 c4 e6 g3 d5 Bg2 dxc4 Nf3" },
+	{ "E06", "d4 Nf6 c4 e6 g3 d5 Bg2 Be7 Nf3" },
+	{ "E10", "d4 Nf6 c4 e6 Nf3" },
+	{ "E10", "d4 Nf6 c4 e6 Nf3 c5" },
+	{ "E11", "d4 Nf6 c4 e6 Nf3 Bb4+" },
+	{ "E12", "d4 Nf6 c4 e6 Nf3 b6" },
+	{ "E12", "d4 Nf6 c4 e6 Nf3 b6 a3" },
+	{ "E12", "d4 Nf6 c4 e6 Nf3 b6 Nc3" },
+	{ "E13", "d4 Nf6 c4 e6 Nf3 b6 Nc3 Bb7 Bg5" },
+	{ "E14", "d4 Nf6 c4 e6 Nf3 b6 e3" },
+	{ "E15", "d4 Nf6 c4 e6 Nf3 b6 g3" },
+	{ "E15", "d4 Nf6 c4 e6 Nf3 b6 g3 Ba6" },
+	{ "E16", "d4 Nf6 c4 e6 Nf3 b6 g3 Bb7 Bg2 Bb4+" },
+	{ "E17", "d4 Nf6 c4 e6 Nf3 b6 g3 Bb7 Bg2 Be7" },
+	{ "E18", "d4 Nf6 c4 e6 Nf3 b6 g3 Bb7 Bg2 Be7 O-O O-O Nc3" },
+	{ "E20", "d4 Nf6 c4 e6 Nc3 Bb4" },
+	{ "E20", "d4 Nf6 c4 e6 Nc3 Bb4 f3" },
+	{ "E21", "d4 Nf6 c4 e6 Nc3 Bb4 Nf3" },
+	{ "E22", "d4 Nf6 c4 e6 Nc3 Bb4 Qb3" },
+	{ "E24", "d4 Nf6 c4 e6 Nc3 Bb4 a3 Bxc3+ bxc3" },
+	{ "E30", "d4 Nf6 c4 e6 Nc3 Bb4 Bg5" },
+	{ "E31", "d4 Nf6 c4 e6 Nc3 Bb4 Bg5 h6 Bh4 c5 d5 d6" },
+	{ "E32", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2" },
+	{ "E32", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 O-O" },
+	{ "E33", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 Nc6" },
+	{ "E34", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 d5" },
+	{ "E35", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 d5 cxd5 exd5" },
+	{ "E36", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 d5 a3" },
+	{ "E38", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 c5" },
+	{ "E39", "d4 Nf6 c4 e6 Nc3 Bb4 Qc2 c5 dxc5 O-O" },
+	{ "E40", "d4 Nf6 c4 e6 Nc3 Bb4 e3" },
+	{ "E41", "d4 Nf6 c4 e6 Nc3 Bb4 e3 c5" },
+	{ "E42", "d4 Nf6 c4 e6 Nc3 Bb4 e3 c5 Ne2" },
+	{ "E43", "d4 Nf6 c4 e6 Nc3 Bb4 e3 b6" },
+	{ "E44", "d4 Nf6 c4 e6 Nc3 Bb4 e3 b6 Ne2" },
+	{ "E45", "d4 Nf6 c4 e6 Nc3 Bb4 e3 b6 Ne2 Ba6" },
+	{ "E46", "d4 Nf6 c4 e6 Nc3 Bb4 e3 O-O" },
+	{ "E47", "d4 Nf6 c4 e6 Nc3 Bb4 e3 O-O Bd3" },
+	{ "E48", "d4 Nf6 c4 e6 Nc3 Bb4 e3 O-O Bd3 d5" },
+	{ "E50", "d4 Nf6 c4 e6 Nc3 Bb4 e3 O-O Nf3" },
+	{ "E51", "d4 Nf6 c4 e6 Nc3 Bb4 e3 O-O Nf3 d5" },
+	{ "E60", "d4 Nf6 c4 g6" },
+	{ "E60", "d4 Nf6 c4 g6 Nf3" },
+	{ "E60", "d4 Nf6 c4 g6 g3" },
+	{ "E61", "d4 Nf6 c4 g6 Nc3" },
+	{ "E61", "d4 Nf6 c4 g6 Nc3 Bg7" },
+	{ "E62", "d4 Nf6 c4 g6 Nc3 Bg7 Nf3 d6 g3" },
+	{ "E70", "d4 Nf6 c4 g6 Nc3 Bg7 e4" },
+	{ "E70", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6" },
+	{ "E71", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 h3" },
+	{ "E72", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 g3" },
+	{ "E73", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Be2" },
+	{ "E73", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Be2 O-O" },
+	{ "E73", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Be2 O-O Bg5" },
+	{ "E76", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 f4" },
+	{ "E76", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 f4 O-O" },
+	{ "E80", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 f3" },
+	{ "E81", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 f3 O-O" },
+	{ "E81", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 f3 O-O Be3" },
+	{ "E90", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3" },
+	{ "E90", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O" },
+	{ "E91", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2" },
+	{ "E92", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5" },
+	{ "E92", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 d5" },
+	{ "E94", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 O-O" },
+	{ "E97", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 O-O Nc6" },
+	{ "E97", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 O-O Nc6 d5 Ne7" },
+	{ "E98", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 O-O Nc6 d5 Ne7 Ne1" },
+	{ "E99", "d4 Nf6 c4 g6 Nc3 Bg7 e4 d6 Nf3 O-O Be2 e5 O-O Nc6 d5 Ne7 Ne1 Nd7 f3 f5" }
+};
+
+#define ECOGEN_NB_OF_LINES ((int) (sizeof( ecogen_lines ) / sizeof( EcoGenLine )))
+
+/************************************************************************/
+
+static void ecogen_start_position( Position* pos );
+static bool ecogen_play( Position* pos, const char* san );
+static void ecogen_print_positions( const EcoPosition* positions );
+
+/************************************************************************/
+
+int main()
+{
+	static EcoPosition positions[ ECO_POSITIONS_SIZE ];
+	int cnt = 0;
+
+	for ( int i = 0; i < ECOGEN_NB_OF_LINES; ++i ) {
+
+		Position pos;
+		ecogen_start_position( &pos );
+
+		/* play the line */
+		char moves[ 256 ];
+		strncpy( moves, ecogen_lines[ i ].moves, sizeof( moves ) - 1 );
+		moves[ sizeof( moves ) - 1 ] = '\0';
+
+		for ( char* san = strtok( moves, " " ); san != NULL; san = strtok( NULL, " " ) ) {
+			if ( !ecogen_play( &pos, san ) ) {
+				fprintf( stderr, "ecogen: illegal move %s in %s %s\n", san,
+						ecogen_lines[ i ].eco, ecogen_lines[ i ].moves );
+				return 1;
+			}
+		}
+
+		/* open addressing, linear probing */
+		int slot = (int) (pos.hash & (ECO_POSITIONS_SIZE - 1));
+		while ( positions[ slot ].hash != 0 && positions[ slot ].hash != pos.hash ) {
+			slot = (slot + 1) & (ECO_POSITIONS_SIZE - 1);
+		}
+
+		if ( positions[ slot ].hash == pos.hash ) {
+			/* transposition, the first line listed names the position */
+			fprintf( stderr, "ecogen: %s %s transposes to %s\n", ecogen_lines[ i ].eco,
+					ecogen_lines[ i ].moves, positions[ slot ].eco );
+			continue;
+		}
+
+		positions[ slot ].hash = pos.hash;
+		strncpy( positions[ slot ].eco, ecogen_lines[ i ].eco, sizeof( positions[ slot ].eco ) - 1 );
+
+		cnt++;
+		if ( cnt * 2 > ECO_POSITIONS_SIZE ) {
+			fprintf( stderr, "ecogen: ECO_POSITIONS_SIZE too small\n" );
+			return 1;
+		}
+	}
+
+	printf( "/* generated by ecogen, do not edit */\n\n" );
+	printf( "#include \"ecotables.h\"\n\n" );
+	ecogen_print_positions( positions );
+
+	return 0;
+}
+
+/************************************************************************/
+
+static void ecogen_start_position( Position* pos )
+{
+	static const char* const ranks[ CW_NB_OF_RANKS ] =
+		{ "RNBQKBNR", "PPPPPPPP", "", "", "", "", "pppppppp", "rnbqkbnr" };
+
+	memset( pos, 0, sizeof( Position ) );
+	for ( int r = 0; r < CW_NB_OF_RANKS; ++r ) {
+		for ( int f = 0; ranks[ r ][ f ] != '\0'; ++f ) {
+			pos->board[ r * 8 + f ] = ranks[ r ][ f ];
+		}
+	}
+
+	pos->tomove = WHITE;
+	pos->castling = CHESS_CASTLE_WHITE_KINGSIDE | CHESS_CASTLE_WHITE_QUEENSIDE |
+		CHESS_CASTLE_BLACK_KINGSIDE | CHESS_CASTLE_BLACK_QUEENSIDE;
+	pos->enpassant = CHESS_NO_SQUARE;
+	pos->fullmove = 1;
+
+	chess_setup_position( pos );
+}
+
+static bool ecogen_play( Position* pos, const char* san )
+{
+	bool white = (pos->tomove == WHITE);
+	int homerank = white ? 0 : 56;
+
+	if ( strncmp( san, "O-O-O", 5 ) == 0 ) {
+		chess_perform_move( pos, homerank + 4, homerank + 2, CW_NO_PIECE );
+		return true;
+	}
+	if ( strncmp( san, "O-O", 3 ) == 0 ) {
+		chess_perform_move( pos, homerank + 4, homerank + 6, CW_NO_PIECE );
+		return true;
+	}
+
+	/* [piece][file][rank][x]square[=promotion][+#] */
+	char piece = 'P';
+	const char* s = san;
+	if ( strchr( "NBRQK", *s ) != NULL ) {
+		piece = *s;
+		s++;
+	}
+
+	char buf[ 8 ];
+	int len = 0;
+	bool capture = false;
+	char promotepiece = CW_NO_PIECE;
+	for ( ; *s != '\0' && *s != '+' && *s != '#'; ++s ) {
+		if ( *s == 'x' ) {
+			capture = true;
+		} else if ( *s == '=' ) {
+			promotepiece = white ? s[ 1 ] : tolower( s[ 1 ] );
+			break;
+		} else if ( len < (int) sizeof( buf ) - 1 ) {
+			buf[ len++ ] = *s;
+		}
+	}
+	if ( len < 2 ) {
+		return false;
+	}
+
+	int to = (buf[ len - 2 ] - 'a') + (buf[ len - 1 ] - '1') * 8;
+	int file = -1;
+	int rank = -1;
+	for ( int i = 0; i < len - 2; ++i ) {
+		if ( isdigit( buf[ i ] ) ) {
+			rank = buf[ i ] - '1';
+		} else {
+			file = buf[ i ] - 'a';
+		}
+	}
+
+	if ( !white ) {
+		piece = tolower( piece );
+	}
+
+	int from = chess_find_from_square( pos, to, piece, capture, file, rank );
+	if ( from == CHESS_NO_SQUARE ) {
+		return false;
+	}
+
+	chess_perform_move( pos, from, to, promotepiece );
+	return true;
+}
+
+static void ecogen_print_positions( const EcoPosition* positions )
+{
+	printf( "const EcoPosition eco_positions[ ECO_POSITIONS_SIZE ] =\n{\n" );
+
+	for ( int i = 0; i < ECO_POSITIONS_SIZE; ++i ) {
+		printf( "\t{ 0x%016llxull, \"%s\" }%s\n", (unsigned long long) positions[ i ].hash,
+				positions[ i ].eco, (i + 1 < ECO_POSITIONS_SIZE) ? "," : "" );
+	}
+
+	printf( "};\n" );
+}
@@ -0,0 +1,22 @@
+#ifndef __ecotables_h__
+#define __ecotables_h__
+
+#include <stdint.h>
+
+/* table is generated at build time by ecogen, see Makefile */
+
+/* power of two, at most half full */
+#define ECO_POSITIONS_SIZE 2048
+
+typedef struct
+{
+	/* zobrist hash of the position, 0 for an empty slot */
+	uint64_t hash;
+
+	char eco[ 4 ];
+} EcoPosition;
+
+/* opening positions by hash, open addressing with linear probing */
+extern const EcoPosition eco_positions[ ECO_POSITIONS_SIZE ];
+
+#endif /* __ecotables_h__ */
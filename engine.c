@@ -1,16 +1,21 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "engine.h"
 #include "popen2.h"
+#include "linereader.h"
 #include "log.h"
 
-#ifndef __USE_BSD
-#define __USE_BSD /* for usleep */
-#endif /* __USE_BSD */
-
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
 #include <sys/wait.h>
 #include <sys/select.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -36,209 +41,645 @@ typedef enum
 #define ENGINE_CMD_GO_TIMED_REQ "go movetime "
 #define ENGINE_CMD_STOP_REQ "stop"
 #define ENGINE_CMD_OPTION_ANALYSE "setoption name UCI_AnalyseMode value true"
+#define ENGINE_CMD_SET_OPTION_FMT "setoption name %s value %s"
 
 #define ENGINE_POSITION_CMD_ALLOC_SIZE (16 * 1024)
 
-#define ENGINE_PARSE_SCORE_STR " score "
-#define ENGINE_PARSE_SCORE_CP_STR "cp "
-#define ENGINE_PARSE_SCORE_MATE_STR "mate "
-#define ENGINE_PARSE_LINE_STR " pv "
-#define ENGINE_PARSE_DEPTH_STR " depth "
+/* lines handled per wakeup before requests are looked at again, */
+/* bounds engine_stop() latency when the engine floods its output */
+#define ENGINE_THREAD_BATCH_LINES 256
+
+/* options remembered for engine_settings_key() */
+#define ENGINE_MAX_OPTIONS 32
+
+#define ENGINE_RSP_ID_NAME "id name "
+#define ENGINE_RSP_OPTION_NAME "option name "
+
+/* options listed by the engine in the uci handshake */
+#define ENGINE_MAX_SUPPORTED_OPTIONS 128
+#define ENGINE_MAX_OPTION_NAME 64
+
+#define ENGINE_PARSE_OPTION_TYPE_STR " type "
+#define ENGINE_PARSE_OPTION_SPIN_STR "spin"
+#define ENGINE_PARSE_OPTION_MIN_STR " min "
+#define ENGINE_PARSE_OPTION_MAX_STR " max "
+
+/* part of the free memory given to the hash tables of the pool */
+#define ENGINE_HASH_MEMORY_DIVISOR 4
+
+/* FNV-1a */
+#define ENGINE_HASH_SEED 0xcbf29ce484222325ull
+#define ENGINE_HASH_PRIME 0x100000001b3ull
+
+/* longest wait for the bestmove after stop */
+#define ENGINE_STOP_TIMEOUT_MS 1000
+
+/* longest wait for uciok / readyok */
+#define ENGINE_RSP_TIMEOUT_MS 10000
+
+/* longest wait for the engine to exit after quit, then it is killed */
+#define ENGINE_QUIT_TIMEOUT_MS 1000
+#define ENGINE_QUIT_POLL_MS 10
+
+#define ENGINE_PARSE_BESTMOVE_STR "bestmove"
+
+/* tokens of an info line */
+#define ENGINE_INFO_STR "info"
+#define ENGINE_INFO_DEPTH_STR "depth"
+#define ENGINE_INFO_SELDEPTH_STR "seldepth"
+#define ENGINE_INFO_MULTIPV_STR "multipv"
+#define ENGINE_INFO_SCORE_STR "score"
+#define ENGINE_INFO_CP_STR "cp"
+#define ENGINE_INFO_MATE_STR "mate"
+#define ENGINE_INFO_LOWERBOUND_STR "lowerbound"
+#define ENGINE_INFO_UPPERBOUND_STR "upperbound"
+#define ENGINE_INFO_NODES_STR "nodes"
+#define ENGINE_INFO_NPS_STR "nps"
+#define ENGINE_INFO_HASHFULL_STR "hashfull"
+#define ENGINE_INFO_TBHITS_STR "tbhits"
+#define ENGINE_INFO_TIME_STR "time"
+#define ENGINE_INFO_PV_STR "pv"
+#define ENGINE_INFO_STRING_STR "string"
+
+#define ENGINE_OPTION_MULTIPV "MultiPV"
+
+/***********************************************************/
+
+/* fields of one info line, -1 for those not given */
+typedef struct
+{
+	int depth;
+	int seldepth;
+	int multipv;
+	bool score_given;
+	EngineScoreType score_type;
+	int score;
+	/* lowerbound or upperbound, the score is not exact */
+	bool bound;
+	int64_t nodes;
+	int64_t nps;
+	int hashfull;
+	int64_t tbhits;
+	int64_t time_ms;
+	/* rest of the line after "pv", NULL if none */
+	const char* pv;
+} EngineInfo;
+
+/***********************************************************/
+
+/* one engine process with its reader thread; the thread blocks in poll() */
+/* on the engine output and wakeup, requests are made under engine_mutex */
+/* and then signalled on the eventfd, the thread answers through */
+/* engine_cond */
+typedef struct
+{
+	struct popen2 child;
+	LineReader reader;
+	pthread_t thread;
+	bool thread_started;
+	int wakeup;
+
+	bool thread_stop;
+	bool idle_req;
+	/* thread is not reading engine output nor calling cb */
+	bool idle;
+	/* bestmove of the last go arrived */
+	bool search_done;
+	/* engine stdout closed or failed, the engine process is gone */
+	bool dead;
+	engine_cb_func cb;
+	void* user_data;
+
+	/* lines of the current depth, only touched by the thread; pending */
+	/* until handed to cb */
+	EngineSnapshot snapshot;
+	bool snapshot_pending;
+
+	/* figures of the running search, only touched by the thread; go to */
+	/* stats with the bestmove, under engine_mutex */
+	EngineStats progress;
+	EngineStats stats;
+
+	/* only touched by the thread owning the pool (main) */
+	char* position_cmd;
+	size_t position_cmd_len;
+	size_t position_cmd_size;
+	/* position_cmd changed since it was sent */
+	bool position_changed;
+	EngineColorType color;
+} EngineInstance;
 
 /***********************************************************/
 
-static bool engine_init_done = false;
-static char* engine_position_cmd = NULL;
-static size_t engine_position_cmd_size = 0;
-static EngineColorType engine_color = ENGINE_COLOR_WHITE;
+static EngineInstance engines[ ENGINE_MAX_COUNT ];
+static int engine_nb_of_engines = 0;
+
+static pthread_mutex_t engine_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t engine_cond = PTHREAD_COND_INITIALIZER;
+/* searches ended on any engine */
+static unsigned engine_done_counter = 0;
+
+/* restart the position command from the FEN after irreversible moves */
+static bool engine_position_fen = false;
 
-static struct popen2 engine_child;
-static pthread_t engine_thread_info;
-static bool engine_thread_stop = false;
-static bool engine_thread_idle_req = false;
-static bool engine_thread_idle = true;
-static engine_cb_func engine_cb = NULL;
-static void* engine_user_data = NULL;
+/* hash of the engine name and of every option set, by option name */
+static uint64_t engine_id_key = 0;
+static struct
+{
+	uint64_t name;
+	uint64_t option;
+} engine_options[ ENGINE_MAX_OPTIONS ];
+static int engine_nb_of_options = 0;
+
+/* options the engine supports, empty if it listed none */
+static struct
+{
+	char name[ ENGINE_MAX_OPTION_NAME ];
+	bool spin;
+	long min;
+	long max;
+} engine_supported[ ENGINE_MAX_SUPPORTED_OPTIONS ];
+static int engine_nb_of_supported = 0;
+
+/* MultiPV value sent to the engines */
+static int engine_nb_of_pvs = 1;
 
 /***********************************************************/
 
-static void engine_send_cmd( const char* cmd );
-static bool engine_read_rsp( const char* rsp );
-static bool engine_send_cmd_and_get_rsp( const char* cmd, const char* rsp );
-static bool engine_data_avail( uint32_t to );
-static bool engine_write_ready( uint32_t to );
-static void engine_add_to_position_cmd( const char* data );
-static bool engine_parse_line_and_notify_listener( const char* line );
-static bool engine_read_line( char* line, size_t maxlen );
+static bool engine_start( EngineInstance* engine, const char* bin );
+static void engine_quit( EngineInstance* engine );
+static bool engine_wait_exit( EngineInstance* engine, int timeout_ms );
+static void engine_send_cmd( EngineInstance* engine, const char* cmd );
+static bool engine_read_rsp( EngineInstance* engine, const char* rsp );
+static bool engine_send_cmd_and_get_rsp( EngineInstance* engine, const char* cmd, const char* rsp );
+static bool engine_data_avail( EngineInstance* engine, uint32_t to );
+static bool engine_write_ready( EngineInstance* engine, uint32_t to );
+static void engine_start_position_cmd( EngineInstance* engine, const char* fen );
+static void engine_add_to_position_cmd( EngineInstance* engine, const char* data );
+static int engine_fen_halfmove_clock( const char* fen );
+static bool engine_parse_line_and_notify_listener( EngineInstance* engine, const char* line );
+static bool engine_parse_info( const char* line, EngineInfo* info );
+static const char* engine_next_token( const char* p, size_t* len );
+static bool engine_token_is( const char* token, size_t len, const char* str );
+static void engine_update_progress( EngineInstance* engine, const EngineInfo* info );
+static void engine_end_search_stats( EngineInstance* engine );
+static void engine_deliver_snapshot( EngineInstance* engine );
+static LineReaderStatus engine_read_line( EngineInstance* engine, LineView* line );
 static void* engine_thread( void* arg );
-static bool engine_start_thread();
-static bool engine_stop_thread();
+static void engine_thread_signal( EngineInstance* engine );
+static bool engine_wait_locked( EngineInstance* engine, int timeout_ms );
+static bool engine_is_dead( EngineInstance* engine );
+static bool engine_start_thread( EngineInstance* engine );
+static bool engine_stop_thread( EngineInstance* engine );
+static EngineInstance* engine_get( int e );
+static void engine_deadline( int timeout_ms, struct timespec* until );
 static EngineColorType engine_get_starting_color(const char* startFEN);
+static uint64_t engine_hash_str( uint64_t hash, const char* str );
+static void engine_remember_option( const char* name, const char* value );
+static void engine_parse_option( const char* line );
+static int engine_find_option( const char* name );
+static void engine_set_spin_option( const char* name, long value );
 
 /***********************************************************/
 
-bool engine_init( const char* bin )
+int engine_init( const char* bin, int count )
 {
-	engine_child.child_pid = -1;
-	engine_child.from_child = -1;
-	engine_child.to_child = -1;
-	if ( bin == NULL ) {
-		return false;
+	engine_close();
+
+	if ( bin == NULL || strlen( bin ) < 1 ) {
+		return 0;
 	}
-	if ( strlen( bin ) < 1 ) {
-		return false;
-	}
-	if ( !popen2( bin, &engine_child ) ) {
-		return false;
+	if ( count > ENGINE_MAX_COUNT ) {
+		count = ENGINE_MAX_COUNT;
 	}
 
-	if ( !engine_send_cmd_and_get_rsp( ENGINE_CMD_INIT_REQ, ENGINE_CMD_INIT_RSP ) ) {
-		return false;
+	while ( engine_nb_of_engines < count ) {
+		EngineInstance* engine = &engines[ engine_nb_of_engines ];
+		if ( !engine_start( engine, bin ) ) {
+			engine_quit( engine );
+			break;
+		}
+		engine_nb_of_engines++;
 	}
-	if ( !engine_send_cmd_and_get_rsp( ENGINE_CMD_READY_REQ, ENGINE_CMD_READY_RSP ) ) {
-		return false;
+
+	LOG( INFO, "Engines started: %d of %d", engine_nb_of_engines, count );
+
+	return engine_nb_of_engines;
+}
+
+void engine_close()
+{
+	for ( int e = 0; e < engine_nb_of_engines; ++e ) {
+		engine_quit( &engines[ e ] );
 	}
-	engine_send_cmd( ENGINE_CMD_OPTION_ANALYSE );
+	engine_nb_of_engines = 0;
+	engine_nb_of_supported = 0;
+	engine_nb_of_pvs = 1;
 
-	if ( !engine_start_thread() ) {
-		return false;
+	/* the settings key of the next engine starts from scratch */
+	engine_id_key = 0;
+	engine_nb_of_options = 0;
+}
+
+int engine_count()
+{
+	return engine_nb_of_engines;
+}
+
+bool engine_is_available()
+{
+	for ( int e = 0; e < engine_nb_of_engines; ++e ) {
+		if ( !engine_is_dead( &engines[ e ] ) ) {
+			return true;
+		}
 	}
 
-	engine_init_done = true;
-	return true;
+	return false;
 }
 
-void engine_close()
+bool engine_is_alive( int e )
 {
-	if ( engine_child.child_pid >= 0 ) {
-		engine_send_cmd( ENGINE_CMD_QUIT_REQ );
-		waitpid( engine_child.child_pid, NULL, 0 );
-		popen2_close( &engine_child );
+	EngineInstance* engine = engine_get( e );
+
+	return engine != NULL && !engine_is_dead( engine );
+}
+
+void engine_set_option( const char* name, const char* value )
+{
+	if ( engine_nb_of_engines == 0 ) {
+		return;
+	}
+
+	if ( engine_nb_of_supported > 0 && engine_find_option( name ) < 0 ) {
+		LOG( WARNING, "Engine has no option %s", name );
+		return;
 	}
 
-	if ( engine_init_done ) {
-		engine_stop_thread();
+	char multipv[ 16 ];
+	if ( strcasecmp( name, ENGINE_OPTION_MULTIPV ) == 0 ) {
+		engine_nb_of_pvs = atoi( value );
+		if ( engine_nb_of_pvs < 1 ) {
+			engine_nb_of_pvs = 1;
+		} else if ( engine_nb_of_pvs > ENGINE_MAX_MULTIPV ) {
+			engine_nb_of_pvs = ENGINE_MAX_MULTIPV;
+		}
+		snprintf( multipv, sizeof(multipv), "%d", engine_nb_of_pvs );
+		value = multipv;
 	}
 
-	if ( engine_position_cmd != NULL ) {
-		free( engine_position_cmd );
-		engine_position_cmd = NULL;
-		engine_position_cmd_size = 0;
+	int len = strlen( ENGINE_CMD_SET_OPTION_FMT ) + strlen( name ) + strlen( value );
+	char* tmpstr = malloc( len );
+	snprintf( tmpstr, len, ENGINE_CMD_SET_OPTION_FMT, name, value );
+	for ( int e = 0; e < engine_nb_of_engines; ++e ) {
+		engine_send_cmd( &engines[ e ], tmpstr );
 	}
+	free( tmpstr );
+
+	engine_remember_option( name, value );
+}
 
-	engine_init_done = false;
+bool engine_has_option( const char* name )
+{
+	return engine_find_option( name ) >= 0;
+}
+
+int engine_multipv()
+{
+	return engine_nb_of_pvs;
 }
 
-void engine_new_game(const char* startFEN)
+void engine_copy_line( char* dest, const char* line )
 {
-	if ( !engine_init_done ) {
+	size_t len = strlen( line );
+	if ( len >= ENGINE_MAX_LINE ) {
+		/* whole moves only */
+		len = ENGINE_MAX_LINE - 1;
+		while ( len > 0 && line[ len ] != ' ' ) {
+			len--;
+		}
+	}
+	memcpy( dest, line, len );
+	dest[ len ] = '\0';
+}
+
+void engine_set_resource_options()
+{
+	if ( engine_nb_of_engines == 0 ) {
 		return;
 	}
 
-	engine_send_cmd( ENGINE_CMD_NEW_GAME_REQ );
+	/* one core stays with the viewer */
+	long cores = sysconf( _SC_NPROCESSORS_ONLN );
+	long threads = ( cores > 1 ) ? ( cores - 1 ) / engine_nb_of_engines : 1;
+	engine_set_spin_option( "Threads", threads );
 
-	/* set starting color */
-	engine_color = engine_get_starting_color( startFEN );
+	long pages = sysconf( _SC_AVPHYS_PAGES );
+	long pagesize = sysconf( _SC_PAGESIZE );
+	if ( pages > 0 && pagesize > 0 ) {
+		long mb = ( pages / ENGINE_HASH_MEMORY_DIVISOR / engine_nb_of_engines ) / ( 1024 * 1024 / pagesize );
 
-	if ( engine_position_cmd != NULL ) {
-		engine_position_cmd[ 0 ] = '\0';
+		/* engines take powers of two best */
+		long hash = 1;
+		while ( hash * 2 <= mb ) {
+			hash *= 2;
+		}
+		engine_set_spin_option( "Hash", hash );
 	}
+}
 
-	engine_add_to_position_cmd( "position " );
-	if ( startFEN != NULL ) {
-		engine_add_to_position_cmd( "fen " );
-		engine_add_to_position_cmd( startFEN );
-		engine_add_to_position_cmd( " moves" );
-	} else {
-		engine_add_to_position_cmd( "startpos moves" );
+uint64_t engine_settings_key()
+{
+	uint64_t key = engine_id_key;
+	for ( int i = 0; i < engine_nb_of_options; ++i ) {
+		key ^= engine_options[ i ].option;
+	}
+
+	return key;
+}
+
+void engine_new_game( int e, const char* startFEN )
+{
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
+		return;
 	}
-	engine_send_cmd( engine_position_cmd );
+
+	engine_send_cmd( engine, ENGINE_CMD_NEW_GAME_REQ );
+	engine_set_start_position( e, startFEN );
 }
 
-void engine_add_move( const char* long_algebraic )
+void engine_set_start_position( int e, const char* startFEN )
 {
-	if ( !engine_init_done ) {
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
 		return;
 	}
 
-	engine_add_to_position_cmd( " " );
-	engine_add_to_position_cmd( long_algebraic );
+	/* set starting color */
+	engine->color = engine_get_starting_color( startFEN );
+
+	engine_start_position_cmd( engine, startFEN );
+}
 
-	engine_send_cmd( engine_position_cmd );
+void engine_set_position_fen( bool on )
+{
+	engine_position_fen = on;
+}
+
+void engine_add_move( int e, const char* long_algebraic, const char* fen )
+{
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
+		return;
+	}
+
+	/* nothing before a pawn move or capture can repeat, the engine */
+	/* loses no history when the position starts from here */
+	if ( engine_position_fen && fen != NULL && engine_fen_halfmove_clock( fen ) == 0 ) {
+		engine_start_position_cmd( engine, fen );
+	} else {
+		engine_add_to_position_cmd( engine, " " );
+		engine_add_to_position_cmd( engine, long_algebraic );
+	}
 
 	/* toggle color */
-	if ( engine_color == ENGINE_COLOR_WHITE ) {
-		engine_color = ENGINE_COLOR_BLACK;
+	if ( engine->color == ENGINE_COLOR_WHITE ) {
+		engine->color = ENGINE_COLOR_BLACK;
 	} else {
-		engine_color = ENGINE_COLOR_WHITE;
+		engine->color = ENGINE_COLOR_WHITE;
 	}
 }
 
-void engine_go( int time_ms, engine_cb_func cb, void* user_data )
+void engine_go( int e, int time_ms, engine_cb_func cb, void* user_data )
 {
-	if ( !engine_init_done ) {
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
 		return;
 	}
 
-	engine_user_data = user_data;
-	engine_cb = cb;
-	engine_thread_idle_req = false;
+	/* moves added since the last search go over in one command */
+	if ( engine->position_changed && engine->position_cmd != NULL ) {
+		engine_send_cmd( engine, engine->position_cmd );
+		engine->position_changed = false;
+	}
+
+	pthread_mutex_lock( &engine_mutex );
+	engine->user_data = user_data;
+	engine->cb = cb;
+	engine->idle_req = false;
+	engine->search_done = ( time_ms == 0 );
+	pthread_mutex_unlock( &engine_mutex );
+	engine_thread_signal( engine );
 
 	if ( time_ms < 0 ) {
-		engine_send_cmd( ENGINE_CMD_GO_INFINITE_REQ );
+		engine_send_cmd( engine, ENGINE_CMD_GO_INFINITE_REQ );
 	} else if ( time_ms > 0 ) {
 		int len = strlen(ENGINE_CMD_GO_TIMED_REQ) + 16;
 		char* tmpstr = malloc( len );
 		snprintf( tmpstr, len, "%s%d", ENGINE_CMD_GO_TIMED_REQ, time_ms );
-		engine_send_cmd( tmpstr );
+		engine_send_cmd( engine, tmpstr );
 		free( tmpstr );
 	}
 }
 
-void engine_stop()
+bool engine_get_stats( int e, EngineStats* stats )
+{
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
+		return false;
+	}
+
+	pthread_mutex_lock( &engine_mutex );
+	*stats = engine->stats;
+	pthread_mutex_unlock( &engine_mutex );
+
+	return true;
+}
+
+bool engine_is_done( int e )
+{
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
+		return true;
+	}
+
+	pthread_mutex_lock( &engine_mutex );
+	bool done = engine->search_done || engine->dead;
+	pthread_mutex_unlock( &engine_mutex );
+
+	return done;
+}
+
+unsigned engine_done_count()
 {
-	if ( !engine_init_done ) {
+	pthread_mutex_lock( &engine_mutex );
+	unsigned count = engine_done_counter;
+	pthread_mutex_unlock( &engine_mutex );
+
+	return count;
+}
+
+void engine_wait_done( unsigned count, int timeout_ms )
+{
+	struct timespec until;
+	engine_deadline( timeout_ms, &until );
+
+	pthread_mutex_lock( &engine_mutex );
+	while ( engine_done_counter == count ) {
+		if ( pthread_cond_timedwait( &engine_cond, &engine_mutex, &until ) != 0 ) {
+			break;
+		}
+	}
+	pthread_mutex_unlock( &engine_mutex );
+}
+
+void engine_stop( int e )
+{
+	EngineInstance* engine = engine_get( e );
+	if ( engine == NULL ) {
 		return;
 	}
 
-	engine_send_cmd( ENGINE_CMD_STOP_REQ );
+	engine_send_cmd( engine, ENGINE_CMD_STOP_REQ );
 
-	engine_thread_idle_req = true;
-	while ( !engine_thread_idle ) {
-		usleep( 1 * 1000 );
+	/* the bestmove is read here, a later go must not take it for its own; */
+	/* returns once the thread is done with the current batch of lines, */
+	/* after that the callback is not called any more */
+	pthread_mutex_lock( &engine_mutex );
+	if ( !engine_wait_locked( engine, ENGINE_STOP_TIMEOUT_MS ) ) {
+		LOG( WARNING, "Engine %d sent no bestmove after stop", e );
 	}
-	engine_user_data = NULL;
-	engine_cb = NULL;
+	engine->idle_req = true;
+	engine_thread_signal( engine );
+	while ( !engine->idle ) {
+		pthread_cond_wait( &engine_cond, &engine_mutex );
+	}
+	engine->user_data = NULL;
+	engine->cb = NULL;
+	pthread_mutex_unlock( &engine_mutex );
 }
 
 /***********************************************************/
 
-static void engine_send_cmd( const char* cmd )
+static bool engine_start( EngineInstance* engine, const char* bin )
+{
+	memset( engine, 0, sizeof(EngineInstance) );
+	engine->child.child_pid = -1;
+	engine->child.from_child = -1;
+	engine->child.to_child = -1;
+	engine->wakeup = -1;
+
+	if ( !popen2( bin, &engine->child ) ) {
+		return false;
+	}
+	linereader_init( &engine->reader, engine->child.from_child );
+
+	if ( !engine_send_cmd_and_get_rsp( engine, ENGINE_CMD_INIT_REQ, ENGINE_CMD_INIT_RSP ) ) {
+		return false;
+	}
+	if ( !engine_send_cmd_and_get_rsp( engine, ENGINE_CMD_READY_REQ, ENGINE_CMD_READY_RSP ) ) {
+		return false;
+	}
+	engine_send_cmd( engine, ENGINE_CMD_OPTION_ANALYSE );
+
+	return engine_start_thread( engine );
+}
+
+static void engine_quit( EngineInstance* engine )
+{
+	/* the thread polls the pipes, it is gone before they are closed */
+	if ( engine->thread_started ) {
+		engine_stop_thread( engine );
+	}
+
+	if ( engine->child.child_pid >= 0 ) {
+		engine_send_cmd( engine, ENGINE_CMD_QUIT_REQ );
+		if ( !engine_wait_exit( engine, ENGINE_QUIT_TIMEOUT_MS ) ) {
+			LOG( WARNING, "Engine %d did not quit, killed", (int) ( engine - engines ) );
+			kill( engine->child.child_pid, SIGKILL );
+			waitpid( engine->child.child_pid, NULL, 0 );
+		}
+		popen2_close( &engine->child );
+	}
+
+	if ( engine->stats.searches > 0 ) {
+		EngineStats* stats = &engine->stats;
+		LOG( INFO, "Engine %d: %llu searches, %llu nodes in %llu ms, %llu nps",
+				(int) ( engine - engines ), (unsigned long long) stats->searches,
+				(unsigned long long) stats->total_nodes, (unsigned long long) stats->total_time_ms,
+				(unsigned long long) ( stats->total_time_ms > 0 ?
+						( stats->total_nodes * 1000 ) / stats->total_time_ms : 0 ) );
+	}
+
+	free( engine->position_cmd );
+	engine->position_cmd = NULL;
+	engine->position_cmd_len = 0;
+	engine->position_cmd_size = 0;
+}
+
+/* true once the engine process has exited and is reaped */
+static bool engine_wait_exit( EngineInstance* engine, int timeout_ms )
 {
-	if ( !engine_write_ready(300) ) {
+	const struct timespec step = { 0, 1000000L * ENGINE_QUIT_POLL_MS };
+
+	for ( int waited = 0; ; waited += ENGINE_QUIT_POLL_MS ) {
+		pid_t pid = waitpid( engine->child.child_pid, NULL, WNOHANG );
+		if ( pid != 0 && !( pid < 0 && errno == EINTR ) ) {
+			/* reaped, or no child of ours any more */
+			return true;
+		}
+		if ( waited >= timeout_ms ) {
+			return false;
+		}
+		nanosleep( &step, NULL );
+	}
+}
+
+static void engine_send_cmd( EngineInstance* engine, const char* cmd )
+{
+	if ( engine_is_dead( engine ) ) {
+		return;
+	}
+
+	if ( !engine_write_ready( engine, 300 ) ) {
 
 		LOG( WARNING, "Engine is not ready to receive input");
 		return;
 	}
 
-	write( engine_child.to_child, cmd, strlen(cmd) );
-	write( engine_child.to_child, "\n", 1 );
-	LOG(DEBUG, "Engine cmd: %s", cmd);
+	write( engine->child.to_child, cmd, strlen(cmd) );
+	write( engine->child.to_child, "\n", 1 );
+	LOG(DEBUG, "Engine %d cmd: %s", (int) ( engine - engines ), cmd);
 }
 
-static bool engine_read_rsp( const char* rsp )
+static bool engine_read_rsp( EngineInstance* engine, const char* rsp )
 {
-	const char* fpos = rsp;
+	size_t rsplen = strlen( rsp );
 
-	while ( *fpos ) {
+	while ( true ) {
 
-		char c = '\0';
-		if ( read( engine_child.from_child, &c, sizeof(char) ) > 0 ) {
-			if ( c == *fpos ) {
-				++fpos;
-			} else {
-				fpos = rsp;
+		LineView line;
+		LineReaderStatus status = engine_read_line( engine, &line );
+
+		if ( status == LINEREADER_LINE ) {
+			if ( strncmp( line.data, rsp, rsplen ) == 0 ) {
+				break;
+			}
+			/* all engines of the pool run the same binary */
+			if ( engine == engines && strncmp( line.data, ENGINE_RSP_ID_NAME, strlen( ENGINE_RSP_ID_NAME ) ) == 0 ) {
+				LOG( INFO, "Engine name: %s", line.data + strlen( ENGINE_RSP_ID_NAME ) );
+				engine_id_key = engine_hash_str( ENGINE_HASH_SEED, line.data );
+			}
+			if ( engine == engines && strncmp( line.data, ENGINE_RSP_OPTION_NAME, strlen( ENGINE_RSP_OPTION_NAME ) ) == 0 ) {
+				engine_parse_option( line.data + strlen( ENGINE_RSP_OPTION_NAME ) );
 			}
+		} else if ( status == LINEREADER_AGAIN ) {
+			if ( !engine_data_avail( engine, ENGINE_RSP_TIMEOUT_MS ) ) {
+				LOG( ERROR, "Engine did not respond with %s", rsp );
+				return false;
+			}
+		} else {
+			return false;
 		}
 	}
 
@@ -247,42 +688,38 @@ static bool engine_read_rsp( const char* rsp )
 	return true;
 }
 
-static bool engine_send_cmd_and_get_rsp( const char* cmd, const char* rsp )
+static bool engine_send_cmd_and_get_rsp( EngineInstance* engine, const char* cmd, const char* rsp )
 {
-	engine_send_cmd( cmd );
-	return engine_read_rsp( rsp );
+	engine_send_cmd( engine, cmd );
+	return engine_read_rsp( engine, rsp );
 }
 
-static bool engine_data_avail( uint32_t to )
+static bool engine_data_avail( EngineInstance* engine, uint32_t to )
 {
-	fd_set fds;
-	FD_ZERO( &fds );
-	FD_SET( engine_child.from_child, &fds );
+	struct pollfd pfd;
+	pfd.fd = engine->child.from_child;
+	pfd.events = POLLIN;
 
-	struct timeval timeout;
-	timeout.tv_sec = to / 1000;
-	timeout.tv_usec = 1000 * ( to % 1000 );
+	int pres = 0;
+	do {
+		pres = poll( &pfd, 1, to );
+	} while ( pres < 0 && errno == EINTR );
 
-	int sres = select( engine_child.from_child + 1, &fds, NULL, NULL, &timeout);
-
-	if ( sres != 1 ) {
-		return false;
-	}
-
-	return true;
+	/* end of file (POLLHUP) is data too, the reader reports it */
+	return pres == 1;
 }
 
-static bool engine_write_ready( uint32_t to )
+static bool engine_write_ready( EngineInstance* engine, uint32_t to )
 {
 	fd_set fds;
 	FD_ZERO( &fds );
-	FD_SET( engine_child.to_child, &fds );
+	FD_SET( engine->child.to_child, &fds );
 
 	struct timeval timeout;
 	timeout.tv_sec = to / 1000;
 	timeout.tv_usec = 1000 * ( to % 1000 );
 
-	int sres = select( engine_child.to_child + 1, NULL, &fds, NULL, &timeout);
+	int sres = select( engine->child.to_child + 1, NULL, &fds, NULL, &timeout);
 
 	if ( sres != 1 ) {
 		return false;
@@ -291,148 +728,493 @@ static bool engine_write_ready( uint32_t to )
 	return true;
 }
 
-static void engine_add_to_position_cmd( const char* data )
+static void engine_start_position_cmd( EngineInstance* engine, const char* fen )
 {
-	size_t addlen = strlen( data );
-	size_t existinglen = (engine_position_cmd == NULL) ?
-				0 : strlen(engine_position_cmd);
+	engine->position_cmd_len = 0;
 
-	bool moremem = false;
-	while ( existinglen + addlen + 1 > engine_position_cmd_size ) {
-		engine_position_cmd_size += ENGINE_POSITION_CMD_ALLOC_SIZE;
-		moremem = true;
+	engine_add_to_position_cmd( engine, "position " );
+	if ( fen != NULL ) {
+		engine_add_to_position_cmd( engine, "fen " );
+		engine_add_to_position_cmd( engine, fen );
+		engine_add_to_position_cmd( engine, " moves" );
+	} else {
+		engine_add_to_position_cmd( engine, "startpos moves" );
 	}
+}
 
-	if ( moremem ) {
-		bool was_empty = ( engine_position_cmd == NULL );
-		engine_position_cmd = realloc( engine_position_cmd,
-				engine_position_cmd_size );
+static void engine_add_to_position_cmd( EngineInstance* engine, const char* data )
+{
+	size_t addlen = strlen( data );
 
-		if ( was_empty ) {
-			engine_position_cmd[ 0 ] = '\0';
+	if ( engine->position_cmd_len + addlen + 1 > engine->position_cmd_size ) {
+		/* doubling keeps appending linear over a whole game */
+		size_t size = ( engine->position_cmd_size > 0 ) ?
+				engine->position_cmd_size : ENGINE_POSITION_CMD_ALLOC_SIZE;
+		while ( engine->position_cmd_len + addlen + 1 > size ) {
+			size *= 2;
 		}
+
+		char* cmd = realloc( engine->position_cmd, size );
+		if ( cmd == NULL ) {
+			LOG( ERROR, "Out of memory for the position command" );
+			return;
+		}
+		engine->position_cmd = cmd;
+		engine->position_cmd_size = size;
 	}
 
-	strcat( engine_position_cmd, data );
+	memcpy( engine->position_cmd + engine->position_cmd_len, data, addlen + 1 );
+	engine->position_cmd_len += addlen;
+	engine->position_changed = true;
 }
 
-static bool engine_read_line( char* line, size_t maxlen )
+/* fifth FEN field, -1 if the FEN has none */
+static int engine_fen_halfmove_clock( const char* fen )
 {
-	if ( maxlen < 1 ) {
-		return false;
+	const char* p = fen;
+	for ( int field = 0; field < 4; ++field ) {
+		p = strchr( p, ' ' );
+		if ( p == NULL ) {
+			return -1;
+		}
+		while ( *p == ' ' ) {
+			++p;
+		}
 	}
 
-	size_t linelen = 0;
-	line[ 0 ] = '\0';
+	if ( *p < '0' || *p > '9' ) {
+		return -1;
+	}
+
+	return atoi( p );
+}
+
+static LineReaderStatus engine_read_line( EngineInstance* engine, LineView* line )
+{
+	LineReaderStatus status = linereader_next( &engine->reader, line );
 
-	char c = '\0';
-	while ( c != '\n' ) {
-		read( engine_child.from_child, &c, 1 );
-		if ( c != '\n' && linelen < (maxlen - 1) ) {
-			line[ linelen ] = c;
-			line[ linelen + 1 ] = '\0';
-			linelen++;
+	if ( status == LINEREADER_EOF || status == LINEREADER_ERROR ) {
+		int e = (int) ( engine - engines );
+		if ( status == LINEREADER_EOF ) {
+			LOG( ERROR, "Engine %d closed its output", e );
+		} else {
+			LOG( ERROR, "Engine %d read failed: %s", e, strerror( engine->reader.error ) );
+		}
+		pthread_mutex_lock( &engine_mutex );
+		if ( !engine->dead ) {
+			engine->dead = true;
+			engine_done_counter++;
 		}
+		pthread_cond_broadcast( &engine_cond );
+		pthread_mutex_unlock( &engine_mutex );
 	}
 
-	return true;
+	return status;
 }
 
-static bool engine_parse_line_and_notify_listener( const char* line )
+static bool engine_parse_line_and_notify_listener( EngineInstance* engine, const char* line )
 {
-	if ( engine_cb == NULL ) {
+	EngineInfo info;
+	if ( !engine_parse_info( line, &info ) ) {
+		return false;
+	}
+
+	engine_update_progress( engine, &info );
+
+	/* bounds come from a search window that failed, the exact score */
+	/* follows */
+	if ( engine->cb == NULL || info.pv == NULL || !info.score_given ||
+		info.bound || info.depth < 0 ) {
 		return true;
 	}
 
-	const char* pline = strstr( line, ENGINE_PARSE_LINE_STR );
-	if ( pline == NULL ) {
+	int score = info.score;
+	if ( engine->color == ENGINE_COLOR_BLACK ) {
+		score = -1 * score;
+	}
+
+	int depth = info.depth;
+	int multipv = ( info.multipv >= 0 ) ? info.multipv : 1;
+	if ( multipv < 1 || multipv > engine_nb_of_pvs ) {
 		return false;
 	}
 
-	pline += strlen( ENGINE_PARSE_LINE_STR );
+	EngineSnapshot* snapshot = &engine->snapshot;
+
+	/* fewer moves than lines, the last depth had all there are */
+	if ( depth != snapshot->depth ) {
+		engine_deliver_snapshot( engine );
+		snapshot->depth = depth;
+	}
+
+	EnginePv* pv = &snapshot->pvs[ multipv - 1 ];
+	pv->type = info.score_type;
+	pv->score = score;
+	engine_copy_line( pv->line, info.pv );
+	if ( multipv > snapshot->nbofpvs ) {
+		snapshot->nbofpvs = multipv;
+	}
+	engine->snapshot_pending = true;
+
+	if ( multipv == engine_nb_of_pvs ) {
+		engine_deliver_snapshot( engine );
+	}
+	return true;
+}
+
+static void engine_deliver_snapshot( EngineInstance* engine )
+{
+	if ( engine->snapshot_pending && engine->cb != NULL ) {
+		engine->cb( &engine->snapshot, engine->user_data );
+	}
+	engine->snapshot_pending = false;
+}
 
-	const char* pscore = strstr( line, ENGINE_PARSE_SCORE_STR );
-	if ( pscore == NULL ) {
+/* one pass over the tokens of an "info ..." line, false for other lines */
+static bool engine_parse_info( const char* line, EngineInfo* info )
+{
+	size_t len = 0;
+	const char* token = engine_next_token( line, &len );
+	if ( !engine_token_is( token, len, ENGINE_INFO_STR ) ) {
 		return false;
 	}
 
-	pscore += strlen( ENGINE_PARSE_SCORE_STR );
-	int score = 0;
-	EngineScoreType type = ENGINE_SCORE_CENTI_PAWN;
+	info->depth = -1;
+	info->seldepth = -1;
+	info->multipv = -1;
+	info->score_given = false;
+	info->score_type = ENGINE_SCORE_CENTI_PAWN;
+	info->score = 0;
+	info->bound = false;
+	info->nodes = -1;
+	info->nps = -1;
+	info->hashfull = -1;
+	info->tbhits = -1;
+	info->time_ms = -1;
+	info->pv = NULL;
+
+	const char* p = token + len;
+	while ( ( token = engine_next_token( p, &len ) ) != NULL ) {
+		p = token + len;
+
+		/* pv and string take the rest of the line */
+		if ( engine_token_is( token, len, ENGINE_INFO_PV_STR ) ) {
+			info->pv = engine_next_token( p, &len );
+			break;
+		}
+		if ( engine_token_is( token, len, ENGINE_INFO_STRING_STR ) ) {
+			break;
+		}
 
-	if ( strstr(pscore, ENGINE_PARSE_SCORE_CP_STR) == pscore ) {
+		if ( engine_token_is( token, len, ENGINE_INFO_LOWERBOUND_STR ) ||
+			engine_token_is( token, len, ENGINE_INFO_UPPERBOUND_STR ) ) {
+			info->bound = true;
+			continue;
+		}
 
-		pscore += strlen( ENGINE_PARSE_SCORE_CP_STR );
-		score = atoi( pscore );
-		type = ENGINE_SCORE_CENTI_PAWN;
+		if ( engine_token_is( token, len, ENGINE_INFO_SCORE_STR ) ) {
+			const char* kind = engine_next_token( p, &len );
+			if ( kind == NULL ) {
+				break;
+			}
+			p = kind + len;
+			if ( engine_token_is( kind, len, ENGINE_INFO_CP_STR ) ) {
+				info->score_type = ENGINE_SCORE_CENTI_PAWN;
+			} else if ( engine_token_is( kind, len, ENGINE_INFO_MATE_STR ) ) {
+				info->score_type = ENGINE_SCORE_MATE;
+			} else {
+				continue;
+			}
+			const char* value = engine_next_token( p, &len );
+			if ( value == NULL ) {
+				break;
+			}
+			p = value + len;
+			info->score = atoi( value );
+			info->score_given = true;
+			continue;
+		}
 
-	} else if ( strstr(pscore, ENGINE_PARSE_SCORE_MATE_STR) == pscore ) {
+		/* the remaining fields have a number, tokens not known here */
+		/* (currmove, cpuload, ...) are passed over one at a time */
+		int64_t* field64 = NULL;
+		int* field = NULL;
+		if ( engine_token_is( token, len, ENGINE_INFO_DEPTH_STR ) ) {
+			field = &info->depth;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_SELDEPTH_STR ) ) {
+			field = &info->seldepth;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_MULTIPV_STR ) ) {
+			field = &info->multipv;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_HASHFULL_STR ) ) {
+			field = &info->hashfull;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_NODES_STR ) ) {
+			field64 = &info->nodes;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_NPS_STR ) ) {
+			field64 = &info->nps;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_TBHITS_STR ) ) {
+			field64 = &info->tbhits;
+		} else if ( engine_token_is( token, len, ENGINE_INFO_TIME_STR ) ) {
+			field64 = &info->time_ms;
+		} else {
+			continue;
+		}
 
-		pscore += strlen( ENGINE_PARSE_SCORE_MATE_STR );
-		score = atoi( pscore );
-		type = ENGINE_SCORE_MATE;
+		const char* value = engine_next_token( p, &len );
+		if ( value == NULL ) {
+			break;
+		}
+		p = value + len;
+		if ( field != NULL ) {
+			*field = atoi( value );
+		} else {
+			*field64 = strtoll( value, NULL, 10 );
+		}
 	}
 
-	if ( engine_color == ENGINE_COLOR_BLACK ) {
-		score = -1 * score;
+	return true;
+}
+
+/* start of the next token from p on and its length, NULL at the end */
+static const char* engine_next_token( const char* p, size_t* len )
+{
+	while ( *p == ' ' || *p == '\t' ) {
+		++p;
+	}
+	if ( *p == '\0' ) {
+		return NULL;
 	}
 
-	const char* pdepth = strstr( line, ENGINE_PARSE_DEPTH_STR );
-	if ( pdepth == NULL ) {
-		return false;
+	const char* end = p;
+	while ( *end != '\0' && *end != ' ' && *end != '\t' ) {
+		++end;
 	}
+	*len = end - p;
+
+	return p;
+}
 
-	pdepth += strlen( ENGINE_PARSE_DEPTH_STR );
-	int depth = atoi( pdepth );
+static bool engine_token_is( const char* token, size_t len, const char* str )
+{
+	return token != NULL && strlen( str ) == len && memcmp( token, str, len ) == 0;
+}
 
-	if ( engine_cb != NULL ) {
+/* the latest figures the engine gave for the running search */
+static void engine_update_progress( EngineInstance* engine, const EngineInfo* info )
+{
+	EngineStats* progress = &engine->progress;
 
-		engine_cb( type, score, depth, pline, engine_user_data );
+	if ( info->depth >= 0 ) {
+		progress->depth = info->depth;
+	}
+	if ( info->seldepth >= 0 ) {
+		progress->seldepth = info->seldepth;
+	}
+	if ( info->nodes >= 0 ) {
+		progress->nodes = (uint64_t) info->nodes;
+	}
+	if ( info->nps >= 0 ) {
+		progress->nps = (uint64_t) info->nps;
+	}
+	if ( info->hashfull >= 0 ) {
+		progress->hashfull = info->hashfull;
+	}
+	if ( info->tbhits >= 0 ) {
+		progress->tbhits = (uint64_t) info->tbhits;
+	}
+	if ( info->time_ms >= 0 ) {
+		progress->time_ms = (uint64_t) info->time_ms;
 	}
-	return true;
 }
 
-static void* engine_thread( void* arg )
+/* with engine_mutex held, after the bestmove */
+static void engine_end_search_stats( EngineInstance* engine )
 {
-	while ( !engine_thread_stop ) {
+	EngineStats* progress = &engine->progress;
+	EngineStats* stats = &engine->stats;
 
-		if ( !engine_thread_idle_req ) {
+	if ( progress->nps == 0 && progress->time_ms > 0 ) {
+		progress->nps = ( progress->nodes * 1000 ) / progress->time_ms;
+	}
 
-			if ( engine_data_avail(10) ) {
+	LOG( DEBUG, "Engine %d search: depth %d/%d nodes %llu nps %llu hashfull %d tbhits %llu time %llu ms",
+			(int) ( engine - engines ), progress->depth, progress->seldepth,
+			(unsigned long long) progress->nodes, (unsigned long long) progress->nps,
+			progress->hashfull, (unsigned long long) progress->tbhits,
+			(unsigned long long) progress->time_ms );
 
-				const size_t MAX_LINE = 1024;
-				char line[ MAX_LINE ];
-				engine_read_line( line, MAX_LINE );
+	uint64_t searches = stats->searches + 1;
+	uint64_t total_nodes = stats->total_nodes + progress->nodes;
+	uint64_t total_time_ms = stats->total_time_ms + progress->time_ms;
 
-				engine_parse_line_and_notify_listener( line );
-			}
+	*stats = *progress;
+	stats->searches = searches;
+	stats->total_nodes = total_nodes;
+	stats->total_time_ms = total_time_ms;
 
-		} else {
-			if ( !engine_thread_idle ) {
-				engine_thread_idle = true;
+	memset( progress, 0, sizeof(EngineStats) );
+}
+
+static void* engine_thread( void* arg )
+{
+	EngineInstance* engine = arg;
+
+	struct pollfd pfds[ 2 ];
+	pfds[ 0 ].fd = engine->wakeup;
+	pfds[ 0 ].events = POLLIN;
+	pfds[ 1 ].fd = engine->child.from_child;
+	pfds[ 1 ].events = POLLIN;
+
+	/* the last batch ended on the line limit, the reader may hold more */
+	/* lines while the pipe is empty already */
+	bool backlog = false;
+
+	while ( true ) {
+
+		pthread_mutex_lock( &engine_mutex );
+		bool stop = engine->thread_stop;
+		bool active = !engine->idle_req && !engine->dead;
+		if ( engine->idle != !active ) {
+			engine->idle = !active;
+			pthread_cond_broadcast( &engine_cond );
+		}
+		pthread_mutex_unlock( &engine_mutex );
+
+		if ( stop ) {
+			break;
+		}
+
+		/* while idle engine output stays in the pipe, only requests wake up; */
+		/* with a backlog only look for requests before the next batch */
+		if ( poll( pfds, active ? 2 : 1, ( active && backlog ) ? 0 : -1 ) < 0 ) {
+			continue;
+		}
+
+		if ( pfds[ 0 ].revents & POLLIN ) {
+			uint64_t count = 0;
+			(void) read( engine->wakeup, &count, sizeof( count ) );
+		}
+
+		if ( active && ( backlog || pfds[ 1 ].revents != 0 ) ) {
+
+			/* what arrived, one read serves many lines */
+			LineView line;
+			backlog = true;
+			for ( int i = 0; i < ENGINE_THREAD_BATCH_LINES; ++i ) {
+				if ( engine_read_line( engine, &line ) != LINEREADER_LINE ) {
+					backlog = false;
+					break;
+				}
+				if ( strncmp( line.data, ENGINE_PARSE_BESTMOVE_STR, strlen( ENGINE_PARSE_BESTMOVE_STR ) ) == 0 ) {
+					/* the next search starts with no lines */
+					engine_deliver_snapshot( engine );
+					engine->snapshot.depth = 0;
+					engine->snapshot.nbofpvs = 0;
+
+					pthread_mutex_lock( &engine_mutex );
+					engine_end_search_stats( engine );
+					engine->search_done = true;
+					engine_done_counter++;
+					pthread_cond_broadcast( &engine_cond );
+					pthread_mutex_unlock( &engine_mutex );
+				} else {
+					engine_parse_line_and_notify_listener( engine, line.data );
+				}
 			}
-			usleep( 1 * 1000 );
 		}
 	}
 
 	return NULL;
 }
 
-static bool engine_start_thread()
+static void engine_thread_signal( EngineInstance* engine )
+{
+	uint64_t one = 1;
+	(void) write( engine->wakeup, &one, sizeof( one ) );
+}
+
+static void engine_deadline( int timeout_ms, struct timespec* until )
+{
+	clock_gettime( CLOCK_REALTIME, until );
+	until->tv_sec += timeout_ms / 1000;
+	until->tv_nsec += 1000000L * ( timeout_ms % 1000 );
+	if ( until->tv_nsec >= 1000000000L ) {
+		until->tv_sec++;
+		until->tv_nsec -= 1000000000L;
+	}
+}
+
+/* with engine_mutex held, true once the search is over or the engine is */
+/* gone */
+static bool engine_wait_locked( EngineInstance* engine, int timeout_ms )
+{
+	struct timespec until;
+	engine_deadline( timeout_ms, &until );
+
+	while ( !engine->search_done && !engine->dead ) {
+		if ( pthread_cond_timedwait( &engine_cond, &engine_mutex, &until ) != 0 ) {
+			break;
+		}
+	}
+
+	return engine->search_done || engine->dead;
+}
+
+static bool engine_is_dead( EngineInstance* engine )
+{
+	pthread_mutex_lock( &engine_mutex );
+	bool dead = engine->dead;
+	pthread_mutex_unlock( &engine_mutex );
+
+	return dead;
+}
+
+static bool engine_start_thread( EngineInstance* engine )
 {
-	int pres = pthread_create( &engine_thread_info, NULL,
-			engine_thread, NULL);
+	engine->wakeup = eventfd( 0, EFD_CLOEXEC );
+	if ( engine->wakeup < 0 ) {
+		return false;
+	}
+
+	engine->thread_stop = false;
+	engine->idle_req = true;
+	engine->idle = true;
+
+	int pres = pthread_create( &engine->thread, NULL,
+			engine_thread, engine );
+
+	if ( pres != 0 ) {
+		close( engine->wakeup );
+		engine->wakeup = -1;
+	}
 
+	engine->thread_started = ( pres == 0 );
 	return pres == 0;
 }
 
-static bool engine_stop_thread()
+static bool engine_stop_thread( EngineInstance* engine )
 {
-	engine_thread_stop = true;
-	pthread_join( engine_thread_info, NULL );
+	pthread_mutex_lock( &engine_mutex );
+	engine->thread_stop = true;
+	pthread_mutex_unlock( &engine_mutex );
+	engine_thread_signal( engine );
+
+	pthread_join( engine->thread, NULL );
+
+	close( engine->wakeup );
+	engine->wakeup = -1;
+	engine->thread_started = false;
 	return true;
 }
 
+static EngineInstance* engine_get( int e )
+{
+	if ( e < 0 || e >= engine_nb_of_engines ) {
+		return NULL;
+	}
+
+	return &engines[ e ];
+}
+
 static EngineColorType engine_get_starting_color(const char* startFEN)
 {
 	EngineColorType result = ENGINE_COLOR_WHITE;
@@ -450,3 +1232,107 @@ static EngineColorType engine_get_starting_color(const char* startFEN)
 
 	return result;
 }
+
+static uint64_t engine_hash_str( uint64_t hash, const char* str )
+{
+	for ( const unsigned char* p = (const unsigned char*) str; *p != '\0'; ++p ) {
+		hash ^= *p;
+		hash *= ENGINE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+/* a later value of the same option replaces the earlier one; left out */
+/* are threads and hash size, they make the search faster, not different, */
+/* and UCI_Chess960, it only changes how castling moves are written and is */
+/* switched per game, the first Chess960 game would make every eval cached */
+/* before it miss */
+static void engine_remember_option( const char* name, const char* value )
+{
+	if ( strcasecmp( name, "Threads" ) == 0 || strcasecmp( name, "Hash" ) == 0 ||
+		strcasecmp( name, "UCI_Chess960" ) == 0 ) {
+		return;
+	}
+
+	uint64_t namehash = engine_hash_str( ENGINE_HASH_SEED, name );
+	uint64_t option = engine_hash_str( engine_hash_str( namehash, "=" ), value );
+
+	for ( int i = 0; i < engine_nb_of_options; ++i ) {
+		if ( engine_options[ i ].name == namehash ) {
+			engine_options[ i ].option = option;
+			return;
+		}
+	}
+
+	if ( engine_nb_of_options < ENGINE_MAX_OPTIONS ) {
+		engine_options[ engine_nb_of_options ].name = namehash;
+		engine_options[ engine_nb_of_options ].option = option;
+		engine_nb_of_options++;
+	}
+}
+
+/* "<id> type <t> [default <x>] [min <x> max <x>] [var <x>]*", the name */
+/* may have spaces */
+static void engine_parse_option( const char* line )
+{
+	const char* ptype = strstr( line, ENGINE_PARSE_OPTION_TYPE_STR );
+	if ( ptype == NULL || engine_nb_of_supported >= ENGINE_MAX_SUPPORTED_OPTIONS ) {
+		return;
+	}
+
+	size_t len = ptype - line;
+	if ( len >= ENGINE_MAX_OPTION_NAME ) {
+		return;
+	}
+
+	memcpy( engine_supported[ engine_nb_of_supported ].name, line, len );
+	engine_supported[ engine_nb_of_supported ].name[ len ] = '\0';
+
+	ptype += strlen( ENGINE_PARSE_OPTION_TYPE_STR );
+	bool spin = ( strncmp( ptype, ENGINE_PARSE_OPTION_SPIN_STR, strlen( ENGINE_PARSE_OPTION_SPIN_STR ) ) == 0 );
+	const char* pmin = strstr( ptype, ENGINE_PARSE_OPTION_MIN_STR );
+	const char* pmax = strstr( ptype, ENGINE_PARSE_OPTION_MAX_STR );
+
+	engine_supported[ engine_nb_of_supported ].spin = spin && pmin != NULL && pmax != NULL;
+	if ( engine_supported[ engine_nb_of_supported ].spin ) {
+		engine_supported[ engine_nb_of_supported ].min = atol( pmin + strlen( ENGINE_PARSE_OPTION_MIN_STR ) );
+		engine_supported[ engine_nb_of_supported ].max = atol( pmax + strlen( ENGINE_PARSE_OPTION_MAX_STR ) );
+	}
+
+	LOG( DEBUG, "Engine option: %s", engine_supported[ engine_nb_of_supported ].name );
+	engine_nb_of_supported++;
+}
+
+/* option names are not case sensitive */
+static int engine_find_option( const char* name )
+{
+	for ( int i = 0; i < engine_nb_of_supported; ++i ) {
+		if ( strcasecmp( engine_supported[ i ].name, name ) == 0 ) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* within the range the engine gave, nothing if it has no such option */
+static void engine_set_spin_option( const char* name, long value )
+{
+	int i = engine_find_option( name );
+	if ( i < 0 || !engine_supported[ i ].spin ) {
+		return;
+	}
+
+	if ( value < engine_supported[ i ].min ) {
+		value = engine_supported[ i ].min;
+	}
+	if ( value > engine_supported[ i ].max ) {
+		value = engine_supported[ i ].max;
+	}
+
+	char valuestr[ 32 ];
+	snprintf( valuestr, sizeof(valuestr), "%ld", value );
+	LOG( INFO, "Engine %s: %s", name, valuestr );
+	engine_set_option( name, valuestr );
+}
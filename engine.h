@@ -3,15 +3,57 @@
 
 
 #include <stdbool.h>
+#include <stdint.h>
 
 
-bool engine_init( const char* bin );
+/* pool of up to ENGINE_MAX_COUNT processes of the same engine, each with */
+/* its own reader thread; the calls taking an engine index e are made from */
+/* one thread, callbacks come from the thread of that engine */
+#define ENGINE_MAX_COUNT 16
+
+/* starts count engines, returns how many came up */
+int engine_init( const char* bin, int count );
 void engine_close();
 
+/* engines started by engine_init(), indices 0 .. engine_count()-1 */
+int engine_count();
+
+/* an engine of the pool is running */
+bool engine_is_available();
+bool engine_is_alive( int e );
+
+/* send a UCI option to all engines, call after engine_init(); options the */
+/* engine did not list in the uci handshake are left out */
+void engine_set_option( const char* name, const char* value );
+
+/* the engine listed the option in the uci handshake */
+bool engine_has_option( const char* name );
+
+/* lines per snapshot, as set through the MultiPV option (1 by default, at */
+/* most ENGINE_MAX_MULTIPV) */
+int engine_multipv();
+
+/* Threads and Hash sized to the machine and shared by the pool: all cores */
+/* but one, a quarter of the free memory */
+void engine_set_resource_options();
+
+/* tells engines and option values apart, e.g. to key cached results */
+uint64_t engine_settings_key();
+
 /* startFEN == NULL means normal start position */
-void engine_new_game( const char* startFEN );
+void engine_new_game( int e, const char* startFEN );
+
+/* back to the start position of the game, unlike engine_new_game() the */
+/* engine keeps its hash */
+void engine_set_start_position( int e, const char* startFEN );
 
-void engine_add_move( const char* long_algebraic );
+/* fen is the position after the move, may be NULL; the position goes to */
+/* the engine with the next engine_go() */
+void engine_add_move( int e, const char* long_algebraic, const char* fen );
+
+/* after a pawn move or capture send "position fen" of the position reached */
+/* instead of the whole move list, keeps the command short in long games */
+void engine_set_position_fen( bool on );
 
 typedef enum
 {
@@ -19,9 +61,64 @@ typedef enum
 	ENGINE_SCORE_MATE
 } EngineScoreType;
 
-typedef void (*engine_cb_func)( EngineScoreType score_type, int score,
-		int depth, const char* best_line_str, void* user_data );
-void engine_go( int time_ms, engine_cb_func cb, void* user_data );
-void engine_stop();
+/* lines of a MultiPV search, and the long algebraic line kept of each */
+#define ENGINE_MAX_MULTIPV 5
+#define ENGINE_MAX_LINE 256
+
+typedef struct
+{
+	EngineScoreType type;
+	/* from white's point of view */
+	int score;
+	char line[ ENGINE_MAX_LINE ];
+} EnginePv;
+
+/* the latest score and line of each multipv index, best first, handed */
+/* over once all lines of a depth are in */
+typedef struct
+{
+	int depth;
+	int nbofpvs;
+	EnginePv pvs[ ENGINE_MAX_MULTIPV ];
+} EngineSnapshot;
+
+typedef void (*engine_cb_func)( const EngineSnapshot* snapshot, void* user_data );
+void engine_go( int e, int time_ms, engine_cb_func cb, void* user_data );
+
+/* true once the search started by engine_go() is over (or the engine is */
+/* gone) */
+bool engine_is_done( int e );
+
+/* what the engine reported of its searches */
+typedef struct
+{
+	/* last search */
+	int depth;
+	int seldepth;
+	uint64_t nodes;
+	uint64_t nps;
+	/* per mille */
+	int hashfull;
+	uint64_t tbhits;
+	uint64_t time_ms;
+
+	/* all searches since engine_init() */
+	uint64_t searches;
+	uint64_t total_nodes;
+	uint64_t total_time_ms;
+} EngineStats;
+
+/* false if there is no engine e */
+bool engine_get_stats( int e, EngineStats* stats );
+
+/* counts searches ended on any engine; engine_wait_done() returns once it */
+/* differs from count, or after timeout_ms */
+unsigned engine_done_count();
+void engine_wait_done( unsigned count, int timeout_ms );
+
+void engine_stop( int e );
+
+/* copies line to dest of ENGINE_MAX_LINE, cut after the last whole move */
+void engine_copy_line( char* dest, const char* line );
 
 #endif /* __engine_h__ */
@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "evalcache.h"
+#include "chesspack.h"
+#include "log.h"
+#include "dbgutil.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/************************************************************************/
+
+#ifndef EVALCACHE_FILE_NAME
+#define EVALCACHE_FILE_NAME "/tmp/.chessviewerscreensaver-evals"
+#endif
+
+#define EVALCACHE_MAGIC "CVEVALS"
+#define EVALCACHE_VERSION 1
+
+/* 4 MiB file, power of two */
+#define EVALCACHE_NB_OF_SLOTS (32 * 1024)
+
+/* a position may go to any slot of its bucket */
+#define EVALCACHE_BUCKET_SIZE 4
+
+/************************************************************************/
+
+typedef struct
+{
+	/* position hash ^ engine, 0 for an empty slot */
+	uint64_t key;
+	uint64_t engine;
+
+	/* with the clocks cleared, tells positions with the same key apart */
+	PackedPosition pos;
+
+	int16_t score;
+	uint8_t type;
+	uint8_t depth;
+	uint32_t unused;
+
+	char line[ EVALCACHE_MAX_LINE ];
+} EvalCacheSlot;
+
+/* same size as a slot, the slots after it stay aligned */
+typedef struct
+{
+	char magic[ 8 ];
+	uint32_t version;
+	uint32_t nbofslots;
+	uint8_t unused[ sizeof(EvalCacheSlot) - 16 ];
+} EvalCacheHeader;
+
+_Static_assert( sizeof(EvalCacheSlot) == 128, "EvalCacheSlot should be 128 bytes" );
+_Static_assert( sizeof(EvalCacheHeader) == sizeof(EvalCacheSlot), "EvalCacheHeader should be one slot" );
+
+#define EVALCACHE_FILE_SIZE ( sizeof(EvalCacheHeader) + EVALCACHE_NB_OF_SLOTS * sizeof(EvalCacheSlot) )
+
+/************************************************************************/
+
+static EvalCacheHeader* evalcache_header = NULL;
+static EvalCacheSlot* evalcache_slots = NULL;
+
+/************************************************************************/
+
+static uint64_t evalcache_key( const Position* pos, uint64_t engine );
+static bool evalcache_pack( const Position* pos, PackedPosition* packed );
+static EvalCacheSlot* evalcache_find( uint64_t key, uint64_t engine, const PackedPosition* packed, bool* found );
+static void evalcache_copy_line( char* dest, const char* line );
+
+/************************************************************************/
+
+bool evalcache_open()
+{
+	evalcache_close();
+
+	int fd = open( EVALCACHE_FILE_NAME, O_RDWR | O_CREAT | O_CLOEXEC, 0600 );
+	if ( fd < 0 ) {
+		LOG( WARNING, "Can't open eval cache %s", EVALCACHE_FILE_NAME );
+		return false;
+	}
+
+	struct stat st;
+	bool fresh = ( fstat( fd, &st ) != 0 || st.st_size != EVALCACHE_FILE_SIZE );
+	if ( fresh && ftruncate( fd, EVALCACHE_FILE_SIZE ) != 0 ) {
+		LOG( WARNING, "Can't size eval cache %s", EVALCACHE_FILE_NAME );
+		close( fd );
+		return false;
+	}
+
+	void* map = mmap( NULL, EVALCACHE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+	/* the mapping keeps the file */
+	close( fd );
+
+	if ( map == MAP_FAILED ) {
+		LOG( WARNING, "Can't map eval cache %s", EVALCACHE_FILE_NAME );
+		return false;
+	}
+
+	evalcache_header = map;
+	evalcache_slots = (EvalCacheSlot*) ( evalcache_header + 1 );
+
+	if ( fresh || memcmp( evalcache_header->magic, EVALCACHE_MAGIC, sizeof(EVALCACHE_MAGIC) ) != 0 ||
+		evalcache_header->version != EVALCACHE_VERSION ||
+		evalcache_header->nbofslots != EVALCACHE_NB_OF_SLOTS ) {
+
+		LOG( INFO, "New eval cache %s", EVALCACHE_FILE_NAME );
+		memset( map, 0, EVALCACHE_FILE_SIZE );
+		memcpy( evalcache_header->magic, EVALCACHE_MAGIC, sizeof(EVALCACHE_MAGIC) );
+		evalcache_header->version = EVALCACHE_VERSION;
+		evalcache_header->nbofslots = EVALCACHE_NB_OF_SLOTS;
+	}
+
+	return true;
+}
+
+void evalcache_close()
+{
+	if ( evalcache_header != NULL ) {
+		munmap( evalcache_header, EVALCACHE_FILE_SIZE );
+		evalcache_header = NULL;
+		evalcache_slots = NULL;
+	}
+}
+
+bool evalcache_lookup( const Position* pos, uint64_t engine, EvalCacheEntry* entry )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( entry != NULL );
+
+	if ( evalcache_slots == NULL ) {
+		return false;
+	}
+
+	PackedPosition packed;
+	if ( !evalcache_pack( pos, &packed ) ) {
+		return false;
+	}
+
+	bool found = false;
+	EvalCacheSlot* slot = evalcache_find( evalcache_key( pos, engine ), engine, &packed, &found );
+	if ( !found ) {
+		return false;
+	}
+
+	entry->type = (EngineScoreType) slot->type;
+	entry->score = slot->score;
+	entry->depth = slot->depth;
+	memcpy( entry->line, slot->line, EVALCACHE_MAX_LINE );
+	entry->line[ EVALCACHE_MAX_LINE - 1 ] = '\0';
+
+	return true;
+}
+
+void evalcache_store( const Position* pos, uint64_t engine, EngineScoreType type,
+		int score, int depth, const char* line )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( line != NULL );
+
+	if ( evalcache_slots == NULL || depth < 0 ) {
+		return;
+	}
+
+	PackedPosition packed;
+	if ( !evalcache_pack( pos, &packed ) ) {
+		return;
+	}
+
+	uint64_t key = evalcache_key( pos, engine );
+
+	bool found = false;
+	EvalCacheSlot* slot = evalcache_find( key, engine, &packed, &found );
+	if ( found && slot->depth > depth ) {
+		return;
+	}
+
+	slot->key = key;
+	slot->engine = engine;
+	slot->pos = packed;
+	slot->score = (int16_t) ( score > INT16_MAX ? INT16_MAX : ( score < INT16_MIN ? INT16_MIN : score ) );
+	slot->type = (uint8_t) type;
+	slot->depth = (uint8_t) ( depth > UINT8_MAX ? UINT8_MAX : depth );
+	evalcache_copy_line( slot->line, line );
+}
+
+/************************************************************************/
+
+static uint64_t evalcache_key( const Position* pos, uint64_t engine )
+{
+	uint64_t key = pos->hash ^ engine;
+
+	return ( key != 0 ) ? key : 1;
+}
+
+/* false if the position does not fit a slot, it is not cached then */
+static bool evalcache_pack( const Position* pos, PackedPosition* packed )
+{
+	if ( !chesspack_pack( pos, packed ) ) {
+		return false;
+	}
+
+	/* an eval holds whatever the move number */
+	packed->halfmove = 0;
+	packed->fullmove = 0;
+
+	return true;
+}
+
+/* slot of the position, else an empty slot or the shallowest one of the */
+/* bucket to replace */
+static EvalCacheSlot* evalcache_find( uint64_t key, uint64_t engine, const PackedPosition* packed, bool* found )
+{
+	size_t first = (size_t) key & ( EVALCACHE_NB_OF_SLOTS - 1 ) & ~( (size_t) EVALCACHE_BUCKET_SIZE - 1 );
+	EvalCacheSlot* bucket = evalcache_slots + first;
+	EvalCacheSlot* victim = NULL;
+
+	for ( int i = 0; i < EVALCACHE_BUCKET_SIZE; ++i ) {
+		EvalCacheSlot* slot = bucket + i;
+
+		if ( slot->key == key && slot->engine == engine &&
+			memcmp( &slot->pos, packed, sizeof(PackedPosition) ) == 0 ) {
+			*found = true;
+			return slot;
+		}
+
+		if ( victim == NULL ||
+			( victim->key != 0 && ( slot->key == 0 || slot->depth < victim->depth ) ) ) {
+			victim = slot;
+		}
+	}
+
+	*found = false;
+	return victim;
+}
+
+static void evalcache_copy_line( char* dest, const char* line )
+{
+	size_t len = strlen( line );
+
+	if ( len >= EVALCACHE_MAX_LINE ) {
+		/* drop the move that does not fit completely */
+		len = EVALCACHE_MAX_LINE - 1;
+		while ( len > 0 && line[ len ] != ' ' ) {
+			len--;
+		}
+	}
+
+	memset( dest, 0, EVALCACHE_MAX_LINE );
+	memcpy( dest, line, len );
+}
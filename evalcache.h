@@ -0,0 +1,36 @@
+#ifndef __evalcache_h__
+#define __evalcache_h__
+
+#include "chess.h"
+#include "engine.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* engine results kept across runs in a memory mapped file, keyed by */
+/* position and engine (engine_settings_key()); lookups and stores must */
+/* not run at the same time, the viewer stores from the engine callbacks */
+/* one at a time and looks up while the engines are stopped */
+
+/* long algebraic moves of the best line, cut after the last whole move */
+#define EVALCACHE_MAX_LINE 72
+
+typedef struct
+{
+	EngineScoreType type;
+	int score;
+	int depth;
+	char line[ EVALCACHE_MAX_LINE ];
+} EvalCacheEntry;
+
+/* false if the file can't be used, the other calls do nothing then */
+bool evalcache_open();
+void evalcache_close();
+
+bool evalcache_lookup( const Position* pos, uint64_t engine, EvalCacheEntry* entry );
+
+/* kept unless a deeper result for the same position and engine is there */
+void evalcache_store( const Position* pos, uint64_t engine, EngineScoreType type,
+		int score, int depth, const char* line );
+
+#endif /* __evalcache_h__ */
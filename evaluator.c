@@ -0,0 +1,438 @@
+#include "evaluator.h"
+#include "dbgutil.h"
+#include "log.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+/***********************************************************/
+
+/* upper bound for the search time, whatever the caller allows */
+#define EVALUATOR_MAX_TIME_MS 20
+
+#define EVALUATOR_MAX_PLY 32
+#define EVALUATOR_INFINITY 32000
+#define EVALUATOR_MATE 30000
+
+/* time is checked every that many nodes (power of two) */
+#define EVALUATOR_NODES_PER_TIME_CHECK 256
+
+/* line string, "e7e8q " per ply */
+#define EVALUATOR_MAX_LINE_STR (EVALUATOR_MAX_PLY * CW_MAX_LONG_ALGEBRAIC_STRING)
+
+typedef struct
+{
+	clock_t deadline;
+	bool abort;
+	long nodes;
+
+	/* triangular principal variation table */
+	ChessMove pv[ EVALUATOR_MAX_PLY ][ EVALUATOR_MAX_PLY ];
+	int pvlen[ EVALUATOR_MAX_PLY ];
+
+	/* line of the last completed iteration, searched first */
+	ChessMove prevpv[ EVALUATOR_MAX_PLY ];
+	int prevpvlen;
+} EvaluatorSearch;
+
+/***********************************************************/
+
+/* pawn, knight, bishop, rook, queen, king */
+static const int evaluator_piece_value[ 6 ] = { 100, 320, 330, 500, 900, 0 };
+
+/* piece-square tables from white's side, a8 first, see evaluator_square() */
+static const int evaluator_pst[ 6 ][ CW_NB_OF_SQUARES ] =
+{
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		 10,  10,  20,  30,  30,  20,  10,  10,
+		  5,   5,  10,  25,  25,  10,   5,   5,
+		  0,   0,   0,  20,  20,   0,   0,   0,
+		  5,  -5, -10,   0,   0, -10,  -5,   5,
+		  5,  10,  10, -20, -20,  10,  10,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0
+	},
+	{
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50
+	},
+	{
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20
+	},
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  5,  10,  10,  10,  10,  10,  10,   5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		  0,   0,   0,   5,   5,   0,   0,   0
+	},
+	{
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		  0,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   5,   5,   5,   5,   5,   0, -10,
+		-10,   0,   5,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20
+	},
+	{
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		 20,  20,   0,   0,   0,   0,  20,  20,
+		 20,  30,  10,   0,   0,  10,  30,  20
+	}
+};
+
+/* king once the queens are off */
+static const int evaluator_pst_king_endgame[ CW_NB_OF_SQUARES ] =
+{
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50
+};
+
+/***********************************************************/
+
+static int evaluator_square( int sq, bool white );
+static int evaluator_evaluate( const Position* pos );
+static int evaluator_move_order_score( const Position* pos, const ChessMove* move );
+static void evaluator_sort_moves( const Position* pos, ChessMove* moves, int cnt,
+		const ChessMove* first );
+static bool evaluator_is_tactical( const Position* pos, const ChessMove* move );
+static bool evaluator_time_up( EvaluatorSearch* search );
+static int evaluator_quiesce( EvaluatorSearch* search, const Position* pos, int ply,
+		int alpha, int beta );
+static int evaluator_search( EvaluatorSearch* search, const Position* pos, int depth,
+		int ply, int alpha, int beta );
+static void evaluator_line_str( const ChessMove* line, int len, char* str );
+
+/***********************************************************/
+
+void evaluator_go( const Position* pos, int time_ms, engine_cb_func cb, void* user_data )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( cb != NULL );
+
+	if ( time_ms <= 0 || time_ms > EVALUATOR_MAX_TIME_MS ) {
+		time_ms = EVALUATOR_MAX_TIME_MS;
+	}
+
+	EvaluatorSearch* search = malloc( sizeof( EvaluatorSearch ) );
+	if ( search == NULL ) {
+		return;
+	}
+	memset( search, 0, sizeof( EvaluatorSearch ) );
+
+	clock_t start = clock();
+	search->deadline = start + (clock_t) ( ( (long) time_ms * CLOCKS_PER_SEC ) / 1000 );
+
+	int score = 0;
+	int depth = 0;
+
+	for ( int d = 1; d < EVALUATOR_MAX_PLY; ++d ) {
+
+		int s = evaluator_search( search, pos, d, 0, -EVALUATOR_INFINITY, EVALUATOR_INFINITY );
+		if ( search->abort ) {
+			break;
+		}
+
+		score = s;
+		depth = d;
+		memcpy( search->prevpv, search->pv[ 0 ], search->pvlen[ 0 ] * sizeof( ChessMove ) );
+		search->prevpvlen = search->pvlen[ 0 ];
+
+		/* the next iteration takes several times as long, do not start */
+		/* one that cannot finish */
+		if ( clock() - start > ( search->deadline - start ) / 4 ) {
+			break;
+		}
+		/* mate found, deeper does not change it */
+		if ( abs( score ) > EVALUATOR_MATE - EVALUATOR_MAX_PLY ) {
+			break;
+		}
+	}
+
+	LOG( DEBUG, "Evaluator depth: %d Nodes: %ld", depth, search->nodes );
+
+	if ( depth > 0 ) {
+		EngineScoreType type = ENGINE_SCORE_CENTI_PAWN;
+		if ( abs( score ) > EVALUATOR_MATE - EVALUATOR_MAX_PLY ) {
+			/* mate in full moves, like UCI */
+			int plies = EVALUATOR_MATE - abs( score );
+			score = ( score > 0 ) ? ( plies + 1 ) / 2 : -( plies + 1 ) / 2;
+			type = ENGINE_SCORE_MATE;
+		}
+		if ( pos->tomove == BLACK ) {
+			score = -score;
+		}
+
+		char line[ EVALUATOR_MAX_LINE_STR ];
+		evaluator_line_str( search->prevpv, search->prevpvlen, line );
+
+		EngineSnapshot snapshot;
+		snapshot.depth = depth;
+		snapshot.nbofpvs = 1;
+		snapshot.pvs[ 0 ].type = type;
+		snapshot.pvs[ 0 ].score = score;
+		engine_copy_line( snapshot.pvs[ 0 ].line, line );
+
+		cb( &snapshot, user_data );
+	}
+
+	free( search );
+}
+
+/***********************************************************/
+
+static int evaluator_square( int sq, bool white )
+{
+	/* tables are laid out as seen by white, flip the rank for white */
+	return white ? ( 7 - ( sq >> 3 ) ) * 8 + ( sq & 7 ) : sq;
+}
+
+static int evaluator_evaluate( const Position* pos )
+{
+	bool endgame = ( pos->pieces[ chess_piece_index( 'Q' ) ] |
+			pos->pieces[ chess_piece_index( 'q' ) ] ) == BB_EMPTY;
+
+	int score = 0;
+	for ( int i = 0; i < CW_NB_OF_PIECES; ++i ) {
+
+		bool white = i < 6;
+		int kind = i % 6;
+		const int* pst = ( kind == 5 && endgame ) ? evaluator_pst_king_endgame : evaluator_pst[ kind ];
+
+		Bitboard bb = pos->pieces[ i ];
+		while ( bb != BB_EMPTY ) {
+			int sq = bb_pop_first( &bb );
+			int value = evaluator_piece_value[ kind ] + pst[ evaluator_square( sq, white ) ];
+			score += white ? value : -value;
+		}
+	}
+
+	/* from the side to move */
+	return ( pos->tomove == WHITE ) ? score : -score;
+}
+
+static int evaluator_move_order_score( const Position* pos, const ChessMove* move )
+{
+	int score = 0;
+
+	/* most valuable victim, least valuable attacker */
+	char victim = pos->board[ move->to ];
+	if ( victim != CW_NO_PIECE ) {
+		int attacker = chess_piece_index( pos->board[ move->from ] ) % 6;
+		score += 10 * evaluator_piece_value[ chess_piece_index( victim ) % 6 ] - attacker;
+	}
+	if ( move->promotepiece != CW_NO_PIECE ) {
+		score += evaluator_piece_value[ chess_piece_index( move->promotepiece ) % 6 ];
+	}
+
+	return score;
+}
+
+static void evaluator_sort_moves( const Position* pos, ChessMove* moves, int cnt,
+		const ChessMove* first )
+{
+	int scores[ CHESS_MAX_MOVES ];
+	for ( int i = 0; i < cnt; ++i ) {
+		scores[ i ] = evaluator_move_order_score( pos, &( moves[ i ] ) );
+		if ( first != NULL && moves[ i ].from == first->from && moves[ i ].to == first->to &&
+				moves[ i ].promotepiece == first->promotepiece ) {
+			scores[ i ] = EVALUATOR_INFINITY;
+		}
+	}
+
+	/* insertion sort, lists are short */
+	for ( int i = 1; i < cnt; ++i ) {
+		ChessMove m = moves[ i ];
+		int s = scores[ i ];
+		int j = i - 1;
+		while ( j >= 0 && scores[ j ] < s ) {
+			moves[ j + 1 ] = moves[ j ];
+			scores[ j + 1 ] = scores[ j ];
+			j--;
+		}
+		moves[ j + 1 ] = m;
+		scores[ j + 1 ] = s;
+	}
+}
+
+static bool evaluator_is_tactical( const Position* pos, const ChessMove* move )
+{
+	if ( pos->board[ move->to ] != CW_NO_PIECE || move->promotepiece != CW_NO_PIECE ) {
+		return true;
+	}
+
+	/* en passant */
+	char piece = pos->board[ move->from ];
+	return ( piece == 'P' || piece == 'p' ) && move->to == pos->enpassant;
+}
+
+static bool evaluator_time_up( EvaluatorSearch* search )
+{
+	search->nodes++;
+	if ( ( search->nodes & ( EVALUATOR_NODES_PER_TIME_CHECK - 1 ) ) == 0 &&
+			clock() > search->deadline ) {
+		search->abort = true;
+	}
+	return search->abort;
+}
+
+static int evaluator_quiesce( EvaluatorSearch* search, const Position* pos, int ply,
+		int alpha, int beta )
+{
+	search->pvlen[ ply ] = 0;
+
+	int standpat = evaluator_evaluate( pos );
+	if ( standpat >= beta || ply >= EVALUATOR_MAX_PLY - 1 ) {
+		return standpat;
+	}
+	if ( standpat > alpha ) {
+		alpha = standpat;
+	}
+
+	ChessMove moves[ CHESS_MAX_MOVES ];
+	int cnt = chess_legal_moves( pos, moves );
+
+	/* captures and promotions only */
+	int ncaptures = 0;
+	for ( int i = 0; i < cnt; ++i ) {
+		if ( evaluator_is_tactical( pos, &( moves[ i ] ) ) ) {
+			moves[ ncaptures++ ] = moves[ i ];
+		}
+	}
+	evaluator_sort_moves( pos, moves, ncaptures, NULL );
+
+	for ( int i = 0; i < ncaptures; ++i ) {
+
+		if ( evaluator_time_up( search ) ) {
+			return 0;
+		}
+
+		Position next;
+		memcpy( &next, pos, sizeof( Position ) );
+		chess_perform_move( &next, moves[ i ].from, moves[ i ].to, moves[ i ].promotepiece );
+
+		int score = -evaluator_quiesce( search, &next, ply + 1, -beta, -alpha );
+		if ( search->abort ) {
+			return 0;
+		}
+
+		if ( score >= beta ) {
+			return score;
+		}
+		if ( score > alpha ) {
+			alpha = score;
+		}
+	}
+
+	return alpha;
+}
+
+static int evaluator_search( EvaluatorSearch* search, const Position* pos, int depth,
+		int ply, int alpha, int beta )
+{
+	search->pvlen[ ply ] = 0;
+
+	if ( ply > 0 && pos->halfmove >= 100 ) {
+		return 0;
+	}
+
+	ChessMove moves[ CHESS_MAX_MOVES ];
+	int cnt = chess_legal_moves( pos, moves );
+	if ( cnt == 0 ) {
+		char king = ( pos->tomove == WHITE ) ? 'K' : 'k';
+		return chess_is_in_check( pos, king ) ? -EVALUATOR_MATE + ply : 0;
+	}
+
+	if ( depth <= 0 || ply >= EVALUATOR_MAX_PLY - 1 ) {
+		return evaluator_quiesce( search, pos, ply, alpha, beta );
+	}
+
+	/* the line of the previous iteration first */
+	const ChessMove* first = ( ply < search->prevpvlen ) ? &( search->prevpv[ ply ] ) : NULL;
+	evaluator_sort_moves( pos, moves, cnt, first );
+
+	int best = -EVALUATOR_INFINITY;
+	for ( int i = 0; i < cnt; ++i ) {
+
+		/* the first iteration always completes */
+		if ( depth > 1 && evaluator_time_up( search ) ) {
+			return 0;
+		}
+
+		Position next;
+		memcpy( &next, pos, sizeof( Position ) );
+		chess_perform_move( &next, moves[ i ].from, moves[ i ].to, moves[ i ].promotepiece );
+
+		int score = -evaluator_search( search, &next, depth - 1, ply + 1, -beta, -alpha );
+		if ( search->abort ) {
+			return 0;
+		}
+
+		if ( score > best ) {
+			best = score;
+		}
+		if ( score > alpha ) {
+			alpha = score;
+
+			search->pv[ ply ][ 0 ] = moves[ i ];
+			memcpy( &( search->pv[ ply ][ 1 ] ), search->pv[ ply + 1 ],
+					search->pvlen[ ply + 1 ] * sizeof( ChessMove ) );
+			search->pvlen[ ply ] = search->pvlen[ ply + 1 ] + 1;
+		}
+		if ( alpha >= beta ) {
+			break;
+		}
+	}
+
+	return best;
+}
+
+static void evaluator_line_str( const ChessMove* line, int len, char* str )
+{
+	char* wp = str;
+	for ( int i = 0; i < len; ++i ) {
+		if ( i > 0 ) {
+			*wp++ = ' ';
+		}
+		*wp++ = 'a' + ( line[ i ].from & 7 );
+		*wp++ = '1' + ( line[ i ].from >> 3 );
+		*wp++ = 'a' + ( line[ i ].to & 7 );
+		*wp++ = '1' + ( line[ i ].to >> 3 );
+		if ( line[ i ].promotepiece != CW_NO_PIECE ) {
+			*wp++ = tolower( line[ i ].promotepiece );
+		}
+	}
+	*wp = '\0';
+}
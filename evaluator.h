@@ -0,0 +1,13 @@
+#ifndef __evaluator_h__
+#define __evaluator_h__
+
+#include "chess.h"
+#include "engine.h"
+
+/* small in-process search for when no UCI engine is available: material */
+/* and piece-square tables with an alpha-beta search on top, time boxed */
+/* to at most time_ms; reports like an engine through cb, one line of */
+/* the snapshot */
+void evaluator_go( const Position* pos, int time_ms, engine_cb_func cb, void* user_data );
+
+#endif /* __evaluator_h__ */
@@ -0,0 +1,148 @@
+#include "linereader.h"
+#include "dbgutil.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/************************************************************/
+
+static bool linereader_take_line( LineReader* reader, LineView* line );
+static void linereader_hand_out( LineReader* reader, size_t len, size_t next, LineView* line );
+
+/************************************************************/
+
+void linereader_init( LineReader* reader, int fd )
+{
+	dbgutil_test( reader != NULL );
+
+	reader->fd = fd;
+	reader->start = 0;
+	reader->end = 0;
+	reader->skip = false;
+	reader->eof = false;
+	reader->error = 0;
+
+	/* waiting is up to the caller (select), a read never blocks */
+	int flags = fcntl( fd, F_GETFL );
+	if ( flags >= 0 ) {
+		(void) fcntl( fd, F_SETFL, flags | O_NONBLOCK );
+	}
+}
+
+LineReaderStatus linereader_next( LineReader* reader, LineView* line )
+{
+	dbgutil_test( reader != NULL );
+	dbgutil_test( line != NULL );
+
+	if ( linereader_take_line( reader, line ) ) {
+		return LINEREADER_LINE;
+	}
+
+	if ( reader->error != 0 ) {
+		return LINEREADER_ERROR;
+	}
+
+	if ( reader->eof ) {
+		/* a last line without line end still counts */
+		if ( reader->start < reader->end && !reader->skip ) {
+			linereader_hand_out( reader, reader->end - reader->start, reader->end, line );
+			return LINEREADER_LINE;
+		}
+		reader->start = reader->end = 0;
+		return LINEREADER_EOF;
+	}
+
+	/* keep the partial line, make room behind it */
+	if ( reader->start > 0 ) {
+		memmove( reader->buf, reader->buf + reader->start, reader->end - reader->start );
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+
+	ssize_t n = 0;
+	do {
+		n = read( reader->fd, reader->buf + reader->end, LINEREADER_BUF_SIZE - reader->end );
+	} while ( n < 0 && errno == EINTR );
+
+	if ( n < 0 ) {
+		if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+			return LINEREADER_AGAIN;
+		}
+		reader->error = errno;
+		return LINEREADER_ERROR;
+	}
+
+	if ( n == 0 ) {
+		reader->eof = true;
+		return linereader_next( reader, line );
+	}
+
+	reader->end += n;
+
+	if ( linereader_take_line( reader, line ) ) {
+		return LINEREADER_LINE;
+	}
+
+	return LINEREADER_AGAIN;
+}
+
+/************************************************************/
+
+static bool linereader_take_line( LineReader* reader, LineView* line )
+{
+	while ( reader->start < reader->end ) {
+		char* begin = reader->buf + reader->start;
+		size_t avail = reader->end - reader->start;
+		char* nl = memchr( begin, '\n', avail );
+
+		if ( nl == NULL ) {
+			if ( avail < LINEREADER_BUF_SIZE ) {
+				return false;
+			}
+
+			/* a full buffer without line end, cut the line here */
+			if ( reader->skip ) {
+				reader->start = reader->end = 0;
+				return false;
+			}
+			reader->skip = true;
+			linereader_hand_out( reader, avail, reader->end, line );
+			return true;
+		}
+
+		size_t len = nl - begin;
+		size_t next = reader->start + len + 1;
+
+		if ( reader->skip ) {
+			/* end of a line that was cut, already handed out */
+			reader->skip = false;
+			reader->start = next;
+			continue;
+		}
+
+		linereader_hand_out( reader, len, next, line );
+		return true;
+	}
+
+	return false;
+}
+
+static void linereader_hand_out( LineReader* reader, size_t len, size_t next, LineView* line )
+{
+	char* begin = reader->buf + reader->start;
+
+	/* CR LF from engines built for windows */
+	if ( len > 0 && begin[ len - 1 ] == '\r' ) {
+		len--;
+	}
+
+	/* terminate in place, the line end (or the spare byte) is overwritten */
+	begin[ len ] = '\0';
+
+	line->data = begin;
+	line->len = len;
+
+	reader->start = next;
+}
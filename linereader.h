@@ -0,0 +1,59 @@
+#ifndef __linereader_h__
+#define __linereader_h__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* longest line handed out, longer lines are cut there */
+#define LINEREADER_BUF_SIZE (16 * 1024)
+
+typedef enum
+{
+	/* a complete line is in the view */
+	LINEREADER_LINE,
+
+	/* no complete line yet, wait for the descriptor to become readable */
+	LINEREADER_AGAIN,
+
+	/* the other side closed, all lines have been handed out */
+	LINEREADER_EOF,
+
+	/* read failed, see LineReader.error */
+	LINEREADER_ERROR
+} LineReaderStatus;
+
+/* a line inside the reader's buffer without the line end, nul terminated; */
+/* valid until the next call of linereader_next() */
+typedef struct
+{
+	const char* data;
+	size_t len;
+} LineView;
+
+typedef struct
+{
+	int fd;
+
+	/* unread bytes are buf[ start ] up to buf[ end ], a partial line is */
+	/* moved to the front before reading more, so lines never wrap */
+	char buf[ LINEREADER_BUF_SIZE + 1 ];
+	size_t start;
+	size_t end;
+
+	/* rest of a line that was too long, dropped up to its line end */
+	bool skip;
+
+	bool eof;
+
+	/* errno of the failed read */
+	int error;
+} LineReader;
+
+/* fd is switched to non-blocking */
+void linereader_init( LineReader* reader, int fd );
+
+/* next line from the buffer, reading from fd (as much as fits, once per */
+/* call) only when no complete line is buffered */
+LineReaderStatus linereader_next( LineReader* reader, LineView* line );
+
+#endif /* __linereader_h__ */
@@ -1,7 +1,12 @@
 #include "ui.h"
 #include "pgn.h"
 #include "eco.h"
+#include "book.h"
 #include "engine.h"
+#include "evaluator.h"
+#include "evalcache.h"
+#include "chesspack.h"
+#include "analysis.h"
 #include "defs.h"
 #include "log.h"
 #include "cmdline.h"
@@ -20,23 +25,32 @@
 #define PRE_GAME_DELAY_S (1 * movetime_s)
 #define POST_GAME_DELAY_S ( (8 * movetime_s) > 30 ? 30 : (8 * movetime_s) )
 
+/* plies added to the game arrays at a time */
+#define GAME_ALLOC_PLIES 256
+
+/* a cached eval at least this deep is shown without running the engine */
+#define CACHE_DEPTH_DEFAULT 20
+
+/* engine processes analysing side by side */
+#define ENGINE_COUNT_DEFAULT 1
+
 /**************************************************************************/
 
-typedef struct
-{
-	Position pos;
-	int movenum;
-	Color col;
-} EngineMoveInfo;
+/* the current game, decoded before it is shown */
+static AnalysisPly* game_plies = NULL;
+static Move* game_moves = NULL;
+static int game_size = 0;
 
 /***********************************************************************/
 
 static bool next_game( bool random );
-static void update_engine_move_info( EngineMoveInfo* moveinfo,
-		const Position* p, int next_movenum, Color next_color );
-static void redraw_board( const Position* p );
-static void engine_callback( EngineScoreType type, int score,
-		int depth, const char* line_str, void* moveinfo );
+static int decode_game( const Position* start );
+static bool needs_analysis( const Position* p );
+static void draw_position_label( const Position* p );
+static void redraw_board( const Position* p, bool full );
+static void engine_callback( const EngineSnapshot* snapshot, void* ply );
+static void set_engine_option( const char* option );
+static void log_engine_stats();
 static void signal_handler( int signal );
 
 /**********************************************************************/
@@ -72,28 +86,58 @@ int main(int argc, char* argv[])
 		enginetime_ms = ( enginetime_percentage * ( movetime_s * 1000 ) ) / 100;
 	}
 
+	int cache_depth = CACHE_DEPTH_DEFAULT;
+	if ( cmdline.cache_depth != NULL ) {
+		cache_depth = atoi( cmdline.cache_depth );
+	}
+
+	int engine_count = ENGINE_COUNT_DEFAULT;
+	if ( cmdline.engine_count != NULL ) {
+		engine_count = atoi( cmdline.engine_count );
+	}
+
 	if (!pgn_init( cmdline.pgnfile )) {
 		log_close();
 		return 2;
 	}
 
-	if ( engine_init( cmdline.engine ) ) {
+	if ( cmdline.book != NULL ) {
+		/* without a book every position gets an eval */
+		book_open( cmdline.book );
+	}
+
+	if ( engine_init( cmdline.engine, engine_count ) > 0 ) {
 		LOG( INFO, "Engine: %s", cmdline.engine );
+		engine_set_resource_options();
+		if ( cmdline.syzygy_path != NULL ) {
+			/* the engine probes the tablebases during its search */
+			engine_set_option( "SyzygyPath", cmdline.syzygy_path );
+		}
+		/* given last, they win over the values above */
+		for ( int i = 0; i < cmdline.nbofengineoptions; ++i ) {
+			set_engine_option( cmdline.engine_options[ i ] );
+		}
+		engine_set_position_fen( cmdline.position_fen );
+		evalcache_open();
 	} else {
 		LOG( INFO, "No engine" );
 	}
 
+	analysis_init( engine_callback, cache_depth );
+
 	if (!ui_init()) {
 		pgn_close();
 		log_close();
 		return 3;
 	}
+	ui_set_nb_of_eval_lines( engine_is_available() ? engine_multipv() : 1 );
+
+	bool engine_chess960 = false;
 
 	while ( next_game( cmdline.random_order ) ) {
 		/* new game, get game info an draw initial board */
 		const GameInfo* info = pgn_game_info();
 		const Position* p = pgn_position();
-		EngineMoveInfo moveinfo;
 
 		LOG( INFO, "Start new game, %s vs. %s",
 			(info != NULL && info->white != NULL) ? info->white : "<Unknown>",
@@ -108,7 +152,16 @@ int main(int argc, char* argv[])
 			(info != NULL) ? info->datestr : "<Unknown>");
 
 		ui_clear();
-		redraw_board(p);
+		redraw_board( p, true );
+
+		int nbofplies = ( NULL != p ) ? decode_game( p ) : 0;
+
+		/* castling goes to the engine as king takes rook in Chess960 */
+		bool chess960 = ( NULL != info && info->chess960 );
+		if ( chess960 != engine_chess960 ) {
+			engine_set_option( "UCI_Chess960", chess960 ? "true" : "false" );
+			engine_chess960 = chess960;
+		}
 
 		if ( NULL != info) {
 			const char* ecoinfo = eco_name( info->eco );
@@ -116,43 +169,51 @@ int main(int argc, char* argv[])
 			ui_draw_game_info( info->white, info->black, info->whiteelo,
 					info->blackelo, info->event, info->round,
 					info->site, info->datestr, info->eco, ecoinfo);
-
-			engine_new_game( info->fen );
-		} else {
-			engine_new_game( NULL );
 		}
 
-		if ( NULL != p) {
-			ui_flush();
+		if ( 0 < nbofplies ) {
+			/* hand over the parsed position, complete with castling */
+			/* rights, en passant square and clocks */
+			Position pos;
+			chesspack_unpack( &game_plies[ 0 ].pos, &pos );
 
-			update_engine_move_info( &moveinfo, p, 1, pgn_next_to_move() );
-			engine_go( enginetime_ms, engine_callback, &moveinfo );
+			char fen[ CW_MAX_FEN_STRING ];
+			if ( NULL != info && NULL != info->fen ) {
+				pgn_position_to_fen( &pos, fen );
+			}
+			analysis_start_game( ( NULL != info && NULL != info->fen ) ? fen : NULL,
+					game_plies, nbofplies );
 
-			sleep( PRE_GAME_DELAY_S );
-			engine_stop();
+			draw_position_label( &pos );
+			ui_flush();
+			analysis_show_ply( 0, 1000 * PRE_GAME_DELAY_S, enginetime_ms );
 
-			const Move* m = pgn_next_move();
+			/* without an ECO tag the opening is named from the position, */
+			/* the deepest known position wins, which also covers */
+			/* transpositions */
+			bool classify = ( NULL == info || 0 == strlen( info->eco ) );
+			const char* opening = NULL;
 
-			while ( NULL != m) {
+			for ( int ply = 1; ply < nbofplies; ++ply ) {
+				const Move* m = &game_moves[ ply ];
 
-				redraw_board(p);
+				chesspack_unpack( &game_plies[ ply ].pos, &pos );
+				redraw_board( &pos, false );
 
 				ui_highlight_move(m->from, m->to);
 				ui_draw_move_str(m->movenum, isupper(m->piece), m->movestr);
-				ui_flush();
 
-				int next_movenum = m->movenum;
-				if ( pgn_next_to_move() == WHITE ) {
-					next_movenum = moveinfo.movenum + 1;
+				if ( classify ) {
+					const char* eco = eco_classify( pos.hash );
+					if ( NULL != eco && eco != opening ) {
+						opening = eco;
+						ui_draw_opening( eco, eco_name( eco ) );
+					}
 				}
-				update_engine_move_info( &moveinfo, p, next_movenum, pgn_next_to_move() );
-				engine_add_move( m->long_algebraic );
-				engine_go( enginetime_ms, engine_callback, &moveinfo );
-
-				sleep( movetime_s );
-				engine_stop();
 
-				m = pgn_next_move();
+				draw_position_label( &pos );
+				ui_flush();
+				analysis_show_ply( ply, 1000 * movetime_s, enginetime_ms );
 			}
 
 			if ( NULL != info) {
@@ -164,7 +225,17 @@ int main(int argc, char* argv[])
 					ui_draw_result( "Black wins" );
 					break;
 				case DRAW:
-					ui_draw_result( "Draw" );
+					switch ( pgn_draw_rule() ) {
+					case DRAW_REPETITION:
+						ui_draw_result( "Draw by repetition" );
+						break;
+					case DRAW_FIFTY_MOVES:
+						ui_draw_result( "Draw by 50 move rule" );
+						break;
+					case DRAW_NONE:
+						ui_draw_result( "Draw" );
+						break;
+					}
 					break;
 				case UNKNOWN:
 					ui_draw_result( "Game ended" );
@@ -176,11 +247,11 @@ int main(int argc, char* argv[])
 
 			ui_flush();
 
-			engine_stop();
 			int engine_time_post_game_ms = ( 1000 * enginetime_percentage * POST_GAME_DELAY_S ) / 100;
-			engine_go( engine_time_post_game_ms, engine_callback, &moveinfo );
-			sleep( POST_GAME_DELAY_S );
-			engine_stop();
+			analysis_show_ply( nbofplies - 1, 1000 * POST_GAME_DELAY_S,
+					engine_time_post_game_ms );
+			analysis_end_game();
+			log_engine_stats();
 
 		} else {
 			ui_flush();
@@ -191,6 +262,10 @@ int main(int argc, char* argv[])
 
 	pgn_close();
 	engine_close();
+	evalcache_close();
+	book_close();
+	free( game_plies );
+	free( game_moves );
 	ui_close();
 	log_close();
 
@@ -207,119 +282,230 @@ static bool next_game( bool random )
 	}
 }
 
-static void update_engine_move_info( EngineMoveInfo* moveinfo,
-		const Position* p, int next_movenum, Color next_color )
+/* all moves of the game from start, which is the position before the */
+/* first move; returns the number of plies including the start position */
+static int decode_game( const Position* start )
 {
-	dbgutil_test( p != NULL );
+	int nbofplies = 0;
+	const Move* m = NULL;
+
+	do {
+		if ( nbofplies >= game_size ) {
+			int size = game_size + GAME_ALLOC_PLIES;
+			AnalysisPly* plies = realloc( game_plies, size * sizeof(AnalysisPly) );
+			Move* moves = realloc( game_moves, size * sizeof(Move) );
+			if ( NULL != plies ) {
+				game_plies = plies;
+			}
+			if ( NULL != moves ) {
+				game_moves = moves;
+			}
+			if ( NULL == plies || NULL == moves ) {
+				LOG( ERROR, "Out of memory, game cut after %d plies", nbofplies );
+				break;
+			}
+			game_size = size;
+		}
+
+		const Position* pos = ( NULL == m ) ? start : pgn_position();
+		AnalysisPly* ply = &game_plies[ nbofplies ];
+		if ( !chesspack_pack( pos, &(ply->pos) ) ) {
+			LOG( WARNING, "More than %d pieces, game cut after %d plies",
+					CHESSPACK_MAX_PIECES, nbofplies );
+			break;
+		}
+		ply->analyse = needs_analysis( pos );
+		if ( NULL == m ) {
+			ply->long_algebraic[ 0 ] = '\0';
+			memset( &game_moves[ nbofplies ], 0, sizeof(Move) );
+		} else {
+			strcpy( ply->long_algebraic, m->long_algebraic );
+			memcpy( &game_moves[ nbofplies ], m, sizeof(Move) );
+		}
+		nbofplies++;
 
-	memcpy( &(moveinfo->pos), p, sizeof( Position ) );
+		m = pgn_next_move();
+	} while ( NULL != m );
 
-	if ( next_movenum > 0 ) {
-		moveinfo->movenum = next_movenum;
+	for ( int i = 0; i < nbofplies; ++i ) {
+		game_plies[ i ].behind = nbofplies - 1 - i;
 	}
-	moveinfo->col = next_color;
+
+	return nbofplies;
 }
 
-static void redraw_board(const Position* p)
+/* book moves are shown while the position is in the opening book and */
+/* dead draws are labeled directly, the other positions get an eval */
+static bool needs_analysis( const Position* p )
 {
-	ui_draw_board();
-	if ( NULL != p) {
-		for (int pos = 0; CW_NB_OF_SQUARES > pos; ++pos) {
-			if (p->board[pos] != ' ') {
-				ui_draw_piece(p->board[pos], pos);
-			}
-		}
+	if ( chess_is_insufficient_material( p ) ) {
+		return false;
 	}
+
+	BookMove book[ CHESS_MAX_MOVES ];
+	return book_moves( p, book ) == 0;
 }
 
-static void engine_callback( EngineScoreType type, int score,
-		int depth, const char* line_str, void* moveinfo )
+static void draw_position_label( const Position* p )
 {
-	dbgutil_test( moveinfo != NULL );
+	if ( chess_is_insufficient_material( p ) ) {
+		ui_draw_engine_eval( "0.00", "Draw, insufficient material" );
+		return;
+	}
 
-	LOG( DEBUG, "Engine score: %d Depth: %d", score, depth );
-	LOG( DEBUG, "Engine line: %s", line_str );
+	BookMove book[ CHESS_MAX_MOVES ];
+	int nbook = book_moves( p, book );
 
-	EngineMoveInfo info;
-	memcpy( &info, moveinfo, sizeof(EngineMoveInfo) );
+	if ( nbook == 0 ) {
+		return;
+	}
 
-	const size_t MAX_EVAL_STR = 128;
-	char pgnlinestr[ MAX_EVAL_STR ];
-	pgnlinestr[ 0 ] = '\0';
+	long total = 0;
+	for ( int i = 0; i < nbook; ++i ) {
+		total += book[ i ].weight;
+	}
 
-	bool ok = true;
-	const char* startp = line_str;
-	const char* endp = NULL;
-	do {
-		endp = strchr( startp, ' ' );
-		char long_algebraic[ CW_MAX_LONG_ALGEBRAIC_STRING ];
+	const size_t MAX_BOOK_STR = 128;
+	char bookstr[ MAX_BOOK_STR ];
+	size_t len = 0;
+	bookstr[ 0 ] = '\0';
+
+	for ( int i = 0; i < nbook; ++i ) {
+		char san[ CW_MAX_MOVE_STRING ];
+		pgn_move_to_san( p, book[ i ].move.from, book[ i ].move.to,
+				book[ i ].move.promotepiece, san );
+
+		/* share of the weights, as often as the book plays the move */
+		int n = snprintf( bookstr + len, MAX_BOOK_STR - len, "%s%s %ld%%",
+				( i > 0 ) ? ", " : "", san, ( 100L * book[ i ].weight + total / 2 ) / total );
+		if ( n < 0 || len + n >= MAX_BOOK_STR ) {
+			/* keep the moves that fit */
+			bookstr[ len ] = '\0';
+			break;
+		}
+		len += n;
+	}
 
-		size_t len = 0;
-		if ( endp != NULL ) {
-			len = endp - startp;
-		} else {
-			len = strlen( line_str ) - (startp - line_str);
+	ui_draw_engine_eval( "Book", bookstr );
+}
+
+static void redraw_board( const Position* p, bool full )
+{
+	/* board as drawn last, after a move only what changed is drawn again; */
+	/* that covers the rook of a castling, the pawn taken en passant and */
+	/* the promoted piece as well */
+	static char shown[ CW_NB_OF_SQUARES ];
+
+	if ( NULL == p ) {
+		ui_draw_board();
+		return;
+	}
+
+	if ( full ) {
+		ui_draw_board();
+		for ( int pos = 0; CW_NB_OF_SQUARES > pos; ++pos ) {
+			if ( p->board[ pos ] != CW_NO_PIECE ) {
+				ui_draw_piece( p->board[ pos ], pos );
+			}
 		}
-		if ( len < CW_MAX_LONG_ALGEBRAIC_STRING ) {
-			strncpy( long_algebraic, startp, len );
-			long_algebraic[ len ] = '\0';
+	} else {
+		Bitboard changed = chess_board_diff( shown, p->board );
+		LOG( DEBUG, "Changed squares: %016llx", (unsigned long long) changed );
+		ui_draw_squares( p->board, changed );
+	}
 
-			char pgnstr[ CW_MAX_MOVE_STRING ];
+	memcpy( shown, p->board, sizeof(shown) );
+}
 
-			ok = pgn_long_algebraic_to_pgn( long_algebraic, pgnstr, &(info.pos) );
-			ok = ok && pgn_long_algebraic_perform_move( long_algebraic, &(info.pos) );
+/* move numbers and side to move of the lines come from the ply's position; */
+/* called on the main thread at most once a frame, Xlib stays on one thread */
+static void engine_callback( const EngineSnapshot* snapshot, void* ply )
+{
+	dbgutil_test( ply != NULL );
 
-			if ( ok ) {
+	const AnalysisPly* info = ply;
 
-				if ( strlen(pgnlinestr) > 0 ) {
-					strcat( pgnlinestr, " " );
-				}
-				if ( info.col == WHITE ) {
-					char numstr[ 16 ];
-					sprintf( numstr, "%d. ", info.movenum );
-					strcat( pgnlinestr, numstr );
-				} else if ( strlen(pgnlinestr) < 1 ) {
-					char numstr[ 16 ];
-					sprintf( numstr, "%d... ", info.movenum );
-					strcat( pgnlinestr, numstr );
-				}
+	Position pos;
+	chesspack_unpack( &(info->pos), &pos );
 
-				if ( info.col == WHITE ) {
-					info.col = BLACK;
-				} else {
-					info.movenum++;
-					info.col = WHITE;
-				}
-				strcat( pgnlinestr, pgnstr );
-			}
-		}
+	const size_t MAX_EVAL_STR = 128;
+	char pgnlinestrs[ ENGINE_MAX_MULTIPV ][ MAX_EVAL_STR ];
+	char scorestrs[ ENGINE_MAX_MULTIPV ][ 32 ];
+	const char* pgnlines[ ENGINE_MAX_MULTIPV ];
+	const char* scores[ ENGINE_MAX_MULTIPV ];
 
-		startp = endp + 1;
+	for ( int i = 0; i < snapshot->nbofpvs; ++i ) {
+		const EnginePv* pv = &snapshot->pvs[ i ];
+		char* scorestr = scorestrs[ i ];
 
-	} while ( ok && (endp != NULL) && (strlen( pgnlinestr ) < (MAX_EVAL_STR - CW_MAX_MOVE_STRING - 1 - 16)) );
+		LOG( DEBUG, "Engine score: %d Depth: %d", pv->score, snapshot->depth );
+		LOG( DEBUG, "Engine line: %s", pv->line );
 
-	LOG( DEBUG, "Engine line: %s", pgnlinestr);
+		pgn_line_to_san( &pos, info->behind, pv->line, pgnlinestrs[ i ], MAX_EVAL_STR );
 
-	char scorestr[ 32 ];
-	if ( type == ENGINE_SCORE_CENTI_PAWN ) {
-		if ( score < 0 ) {
-			scorestr[ 0 ] = '-';
-		} else {
-			scorestr[ 0 ] = '+';
-		}
-		snprintf( scorestr + 1, 31, "%0.2lf", (double) abs(score) / 100.0);
-	} else {
-		if ( score < 0 ) {
-			snprintf( scorestr, 32, "Black Mates in %d", abs(score) );
+		LOG( DEBUG, "Engine line: %s", pgnlinestrs[ i ] );
+
+		if ( pv->type == ENGINE_SCORE_CENTI_PAWN ) {
+			if ( pv->score < 0 ) {
+				scorestr[ 0 ] = '-';
+			} else {
+				scorestr[ 0 ] = '+';
+			}
+			snprintf( scorestr + 1, 31, "%0.2lf", (double) abs(pv->score) / 100.0);
 		} else {
-			snprintf( scorestr, 32, "White Mates in %d", abs(score) );
+			if ( pv->score < 0 ) {
+				snprintf( scorestr, 32, "Black Mates in %d", abs(pv->score) );
+			} else {
+				snprintf( scorestr, 32, "White Mates in %d", abs(pv->score) );
+			}
 		}
+
+		scores[ i ] = scorestr;
+		pgnlines[ i ] = pgnlinestrs[ i ];
 	}
 
-	ui_draw_engine_eval( scorestr, pgnlinestr );
+	ui_draw_engine_evals( scores, pgnlines, snapshot->nbofpvs );
 	ui_flush();
 }
 
+/* "Name=Value" from the command line, the name may have spaces */
+static void set_engine_option( const char* option )
+{
+	const char* eq = strchr( option, '=' );
+	if ( NULL == eq || eq == option ) {
+		LOG( WARNING, "Engine option %s is not Name=Value", option );
+		return;
+	}
+
+	char name[ 128 ];
+	size_t len = eq - option;
+	if ( len >= sizeof(name) ) {
+		LOG( WARNING, "Engine option %s is too long", option );
+		return;
+	}
+	memcpy( name, option, len );
+	name[ len ] = '\0';
+
+	engine_set_option( name, eq + 1 );
+}
+
+/* throughput of each engine so far, to tune the engine time with */
+static void log_engine_stats()
+{
+	for ( int e = 0; e < engine_count(); ++e ) {
+		EngineStats stats;
+		if ( !engine_get_stats( e, &stats ) || 0 == stats.searches ) {
+			continue;
+		}
+
+		LOG( INFO, "Engine %d: %llu nps average, last search depth %d/%d %llu nps hashfull %d tbhits %llu",
+				e, (unsigned long long) ( stats.total_time_ms > 0 ?
+						( stats.total_nodes * 1000 ) / stats.total_time_ms : 0 ),
+				stats.depth, stats.seldepth, (unsigned long long) stats.nps,
+				stats.hashfull, (unsigned long long) stats.tbhits );
+	}
+}
+
 static void signal_handler( int signal )
 {
 	LOG( ERROR, "Caught signal %d", signal );
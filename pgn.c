@@ -14,10 +14,21 @@
 #define PGN_START_BOARD_FEN "rnbqkbnr/pppppppp/8/8/8/8/" \
                             "PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
+#define PGN_HISTORY_ALLOC_SIZE 256
+
+/* longest engine line converted by pgn_line_to_san() */
+#define PGN_MAX_LINE_PLIES 64
+
+#define PGN_SAFE_FREE( p ) if ( NULL != p ) { free( p ); p = NULL; }
+
 GameInfo pgn_gameinfo;
 Position pgn_gameposition;
 Move pgn_move;
-Color pgn_nextmovecolor = WHITE;
+
+/* hash of every position of the game so far, last one is the current */
+uint64_t* pgn_history = NULL;
+int pgn_history_cnt = 0;
+int pgn_history_size = 0;
 
 /**************************************************/
 
@@ -27,20 +38,26 @@ static void pgn_update_move_capture(int movenum, const char* movestr, char piece
 static void pgn_update_move_castle(int movenum, const char* movestr, char kingpiece, bool queenside);
 static void pgn_update_move_en_passant(int movenum, const char* movestr, char pawnpiece, int from, int to, int enpassantcapturepos);
 static void pgn_update_move_promote(int movenum, const char* movestr, char pawnpiece, int from, int to, char promotepiece);
-static void pgn_next_color();
 static char pgn_piece_for_color_to_move(char pgnpiece);
-static int pgn_find_from_pos(Position* pos, int to, char piece, bool capture, int disambiguityfile, int disambiguityrank);
 static void pgn_parse_move(int movenum, const char* pgn);
 static void pgn_parse_result(const char* resultstr);
 static void pgn_fen_to_position(const char* fen, Position* pos);
-static bool pgn_get_color_from_fen(const char* fen, Color* color);
+static const char* pgn_fen_next_field(const char* fen);
+static int pgn_fen_castling_right(const Position* pos, char ch);
+static char* pgn_fen_castling(const Position* pos, Color color, char* wp);
+static bool pgn_is_chess960_start(const Position* pos);
 static char* pgn_game_info_alloc_and_save_str(char* ptr, const char* str);
 static void pgn_game_info_save_str(char* ptr, const char* str, size_t maxlen);
 static void pgn_free_game_info(GameInfo* info);
 static void pgn_long_notation( int from, int to, char promotepiece, char* long_algebraic_str );
-static void pgn_perform_move( char piece, int from, int to, char promotepiece, Position* pos );
-static bool pgn_disambiguity_marker( char piece, int from, int to, Position* pos, char* marker );
+static int pgn_square( const char* str );
+static bool pgn_is_line_move( const Position* pos, int from, int to, char promotepiece );
+static char* pgn_san( const Position* pos, int from, int to, char promotepiece, char* wp );
+static bool pgn_is_line_repetition( const Position* pos, int behind, const uint64_t* linehashes, int plies );
+static int pgn_history_repetitions( const Position* pos, int behind, int plies );
 static bool pgn_init_next_game();
+static void pgn_perform_game_move( int from, int to, char promotepiece );
+static void pgn_history_push( uint64_t hash );
 
 /**************************************************/
 
@@ -62,6 +79,10 @@ void pgn_close()
 	pgn_parser_close();
 
 	pgn_free_game_info(&pgn_gameinfo);
+
+	PGN_SAFE_FREE(pgn_history);
+	pgn_history_cnt = 0;
+	pgn_history_size = 0;
 }
 
 bool pgn_next_game()
@@ -97,7 +118,7 @@ const Move* pgn_next_move()
 
 Color pgn_next_to_move()
 {
-	return pgn_nextmovecolor;
+	return pgn_gameposition.tomove;
 }
 
 const GameInfo* pgn_game_info()
@@ -105,163 +126,179 @@ const GameInfo* pgn_game_info()
 	return &pgn_gameinfo;
 }
 
-bool pgn_long_algebraic_to_pgn( char* long_algebraic, char* pgn, Position* pos )
+int pgn_position_repetitions( const Position* pos, int plies )
 {
-	if ( long_algebraic == NULL || strlen(long_algebraic) < 4 ) {
-		return false;
-	}
+	dbgutil_test( pos != NULL );
+	dbgutil_test( plies >= 0 );
 
-	int from = (long_algebraic[ 0 ] - 'a') + ( (long_algebraic[ 1 ] - '1') * 8 );
-	int to = (long_algebraic[ 2 ] - 'a') + ( (long_algebraic[ 3 ] - '1') * 8 );
+	return pgn_history_repetitions( pos, 0, plies );
+}
 
-	if ( pos == NULL ) {
-		return false;
+DrawRuleType pgn_draw_rule()
+{
+	if ( pgn_position_repetitions( &pgn_gameposition, 0 ) >= 2 ) {
+		return DRAW_REPETITION;
 	}
 
-	Position pos_copy;
-	memcpy( &pos_copy, pos, sizeof(Position) );
-
-	dbgutil_test( from < CW_NB_OF_SQUARES );
-	dbgutil_test( to < CW_NB_OF_SQUARES );
-
-	char frompiece = pos_copy.board[ from ];
-	char topiece = pos_copy.board[ to ];
-	char promotepiece = CW_NO_PIECE;
-	if ( strlen(long_algebraic) > 4 ) {
-		promotepiece = long_algebraic[ 4 ];
-		if ( isupper( frompiece ) ) {
-			promotepiece = toupper( promotepiece );
-		} else {
-			promotepiece = tolower( promotepiece );
-		}
+	if ( pgn_gameposition.halfmove >= 100 ) {
+		return DRAW_FIFTY_MOVES;
 	}
 
-	dbgutil_test( frompiece != CW_NO_PIECE );
-	if ( frompiece == CW_NO_PIECE ) {
-		return false;
-	}
+	return DRAW_NONE;
+}
 
-	char* wp = pgn;
+int pgn_line_to_san( const Position* pos, int behind, const char* moves, char* line, size_t size )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( behind >= 0 );
+	dbgutil_test( moves != NULL );
+	dbgutil_test( line != NULL );
+	dbgutil_test( size > 0 );
 
-	if ( (frompiece == 'k' || frompiece == 'K') &&
-			abs( long_algebraic[ 2 ] - long_algebraic[ 0 ] ) > 1 ) {
+	Position linepos;
+	memcpy( &linepos, pos, sizeof(Position) );
 
-		/* castle */
-		if ( long_algebraic[ 2 ] == 'c' ) {
-			strcpy( wp, "O-O-O" );
-			wp += 5;
-		} else {
-			strcpy( wp, "O-O" );
-			wp += 3;
-		}
+	uint64_t linehashes[ PGN_MAX_LINE_PLIES ];
+	int plies = 0;
 
-	} else if ( frompiece != 'p' && frompiece != 'P' ) {
+	char* wp = line;
+	*wp = '\0';
 
-		char disambiguity_marker[ 3 ];
-		bool disambiguity = pgn_disambiguity_marker( frompiece, from, to,
-				&pos_copy, disambiguity_marker );
+	const char* rp = moves;
+	while ( plies < PGN_MAX_LINE_PLIES ) {
 
-		*wp = toupper(frompiece);
-		wp++;
+		while ( *rp == ' ' ) {
+			rp++;
+		}
 
-		if ( disambiguity ) {
-			char* s = disambiguity_marker;
-			while ( *s != '\0' ) {
+		int from = pgn_square( rp );
+		int to = ( from != CHESS_NO_SQUARE ) ? pgn_square( rp + 2 ) : CHESS_NO_SQUARE;
+		if ( to == CHESS_NO_SQUARE ) {
+			break;
+		}
+		rp += 4;
 
-				*wp = *s;
-				wp++;
-				s++;
-			}
+		char promotepiece = CW_NO_PIECE;
+		if ( *rp != ' ' && *rp != '\0' ) {
+			promotepiece = ( linepos.tomove == WHITE ) ? toupper( *rp ) : tolower( *rp );
+			rp++;
 		}
 
-		if ( topiece != CW_NO_PIECE ) {
-			*wp = 'x';
-			wp++;
+		if ( !pgn_is_line_move( &linepos, from, to, promotepiece ) ) {
+			LOG( DEBUG, "Illegal move in engine line: %.5s", rp - 4 );
+			break;
 		}
-		*wp = long_algebraic[ 2 ];
-		wp++;
-		*wp = long_algebraic[ 3 ];
-		wp++;
-	} else {
-		/* pawn */
-		if ( long_algebraic[ 0 ] != long_algebraic[ 2 ] ) {
-			*wp = long_algebraic[ 0 ];
-			wp++;
-			*wp = 'x';
-			wp++;
+
+		/* move number in front of white moves and of a first black move */
+		char movestr[ 16 + CW_MAX_MOVE_STRING ];
+		char* mp = movestr;
+		if ( plies > 0 ) {
+			*mp++ = ' ';
 		}
-		*wp = long_algebraic[ 2 ];
-		wp++;
-		*wp = long_algebraic[ 3 ];
-		wp++;
-		if ( promotepiece != CW_NO_PIECE ) {
-			*wp = '=';
-			wp++;
-			*wp = toupper( promotepiece );
-			wp++;
+		if ( linepos.tomove == WHITE ) {
+			mp += sprintf( mp, "%d. ", linepos.fullmove );
+		} else if ( plies == 0 ) {
+			mp += sprintf( mp, "%d... ", linepos.fullmove );
 		}
-	}
 
-	/* perform move */
-	pgn_perform_move( frompiece, from, to, promotepiece, &pos_copy );
+		mp = pgn_san( &linepos, from, to, promotepiece, mp );
 
-	bool white_check = chess_is_in_check( pos_copy.board, 'K' );
-	bool black_check = chess_is_in_check( pos_copy.board, 'k' );
-	if ( white_check || black_check ) {
+		chess_perform_move( &linepos, from, to, promotepiece );
 
-		if ( (white_check && chess_is_mated( pos_copy.board, 'K' )) ||
-			(black_check && chess_is_mated( pos_copy.board, 'k' )) ) {
+		/* own king left in check, the engine line is broken */
+		char king = ( linepos.tomove == WHITE ) ? 'k' : 'K';
+		if ( chess_is_in_check( &linepos, king ) ) {
+			LOG( DEBUG, "Illegal move in engine line, king in check" );
+			break;
+		}
 
-			*wp = '#';
-		} else {
-			*wp = '+';
+		/* the legal move list is only needed to tell mate from check */
+		king = ( linepos.tomove == WHITE ) ? 'K' : 'k';
+		if ( chess_is_in_check( &linepos, king ) ) {
+			ChessMove legal[ CHESS_MAX_MOVES ];
+			*mp++ = ( chess_legal_moves( &linepos, legal ) == 0 ) ? '#' : '+';
 		}
-		wp++;
-	}
+		*mp = '\0';
 
-	*wp = '\0';
-	wp++;
+		size_t len = mp - movestr;
+		if ( (size_t) (wp - line) + len >= size ) {
+			break;
+		}
+		memcpy( wp, movestr, len + 1 );
+		wp += len;
 
-	return true;
+		bool repetition = pgn_is_line_repetition( &linepos, behind, linehashes, plies );
+		linehashes[ plies ] = linepos.hash;
+		plies++;
+
+		if ( repetition ) {
+			/* the engine would just repeat the line from here */
+			break;
+		}
+	}
+
+	return plies;
 }
 
-bool pgn_long_algebraic_perform_move( char* long_algebraic, Position* pos )
+void pgn_move_to_san( const Position* pos, int from, int to, char promotepiece, char* san )
 {
-	if ( long_algebraic == NULL || strlen(long_algebraic) < 4 ) {
-		return false;
-	}
+	dbgutil_test( pos != NULL );
+	dbgutil_test( san != NULL );
 
-	int from = (long_algebraic[ 0 ] - 'a') + ( (long_algebraic[ 1 ] - '1') * 8 );
-	int to = (long_algebraic[ 2 ] - 'a') + ( (long_algebraic[ 3 ] - '1') * 8 );
+	char* wp = pgn_san( pos, from, to, promotepiece, san );
+	*wp = '\0';
+}
 
-	if ( pos == NULL ) {
-		return false;
-	}
+void pgn_position_to_fen( const Position* pos, char* fen )
+{
+	dbgutil_test( pos != NULL );
+	dbgutil_test( fen != NULL );
 
-	dbgutil_test( from < CW_NB_OF_SQUARES );
-	dbgutil_test( to < CW_NB_OF_SQUARES );
+	char* wp = fen;
 
-	char frompiece = pos->board[ from ];
-	char promotepiece = CW_NO_PIECE;
-	if ( strlen(long_algebraic) > 4 ) {
-		promotepiece = long_algebraic[ 4 ];
-		if ( isupper( frompiece ) ) {
-			promotepiece = toupper( promotepiece );
-		} else {
-			promotepiece = tolower( promotepiece );
+	/* FEN starts from upper left of board (at a8, that is) */
+	for ( int rank = 7; rank >= 0; --rank ) {
+		int empty = 0;
+		for ( int file = 0; file < CW_NB_OF_FILES; ++file ) {
+			char piece = pos->board[ (CW_NB_OF_FILES * rank) + file ];
+			if ( piece == CW_NO_PIECE ) {
+				empty++;
+			} else {
+				if ( empty > 0 ) {
+					*wp++ = '0' + empty;
+					empty = 0;
+				}
+				*wp++ = piece;
+			}
+		}
+		if ( empty > 0 ) {
+			*wp++ = '0' + empty;
+		}
+		if ( rank > 0 ) {
+			*wp++ = '/';
 		}
 	}
 
-	dbgutil_test( frompiece != CW_NO_PIECE );
+	*wp++ = ' ';
+	*wp++ = ( pos->tomove == WHITE ) ? 'w' : 'b';
+	*wp++ = ' ';
 
-	char piece = frompiece;
-	if ( promotepiece != CW_NO_PIECE ) {
-		piece = toupper( promotepiece );
+	if ( pos->castling == 0 ) {
+		*wp++ = '-';
+	} else {
+		wp = pgn_fen_castling( pos, WHITE, wp );
+		wp = pgn_fen_castling( pos, BLACK, wp );
 	}
+	*wp++ = ' ';
 
-	pgn_perform_move( piece, from, to, promotepiece, pos );
+	if ( pos->enpassant == CHESS_NO_SQUARE ) {
+		*wp++ = '-';
+	} else {
+		*wp++ = 'a' + ( pos->enpassant & 7 );
+		*wp++ = '1' + ( pos->enpassant >> 3 );
+	}
 
-	return true;
+	sprintf( wp, " %d %d", pos->halfmove, pos->fullmove );
 }
 
 /**************************************************/
@@ -288,13 +325,16 @@ static void pgn_update_info(const char* tag, const char* value)
 		pgn_game_info_save_str(pgn_gameinfo.whiteelo, value, PGN_MAX_LEN_ELO);
 	} else if (strcmp(tag, "BlackElo") == 0) {
 		pgn_game_info_save_str(pgn_gameinfo.blackelo, value, PGN_MAX_LEN_ELO);
+	} else if (strcmp(tag, "Variant") == 0) {
+		/* "Chess960", "chess 960", "Fischerandom" */
+		pgn_gameinfo.chess960 = strstr(value, "960") != NULL || strstr(value, "ischer") != NULL;
 	}
 }
 
 static char pgn_piece_for_color_to_move(char pgnpiece)
 {
 	/* white uppercase, black lowercase */
-	if (WHITE == pgn_nextmovecolor) {
+	if (WHITE == pgn_gameposition.tomove) {
 		return toupper(pgnpiece);
 	} else {
 		return tolower(pgnpiece);
@@ -316,8 +356,7 @@ static void pgn_update_move_normal(int movenum, const char* movestr, char piece,
 
 	LOG(INFO, "Next move: %c %d  -->  %d", piece, from, to);
 
-	pgn_gameposition.board[pgn_move.from] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.to] = pgn_move.piece;
+	pgn_perform_game_move(pgn_move.from, pgn_move.to, CW_NO_PIECE);
 }
 
 static void pgn_update_move_capture(int movenum, const char* movestr, char piece, int from, int to)
@@ -336,8 +375,7 @@ static void pgn_update_move_capture(int movenum, const char* movestr, char piece
 
 	LOG(INFO, "Next move: %c %d  x  %d", piece, from, to);
 
-	pgn_gameposition.board[pgn_move.from] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.to] = pgn_move.piece;
+	pgn_perform_game_move(pgn_move.from, pgn_move.to, CW_NO_PIECE);
 }
 
 static void pgn_update_move_castle(int movenum, const char* movestr, char kingpiece, bool queenside)
@@ -356,47 +394,45 @@ static void pgn_update_move_castle(int movenum, const char* movestr, char kingpi
 		pgn_move.castlerookpiece = 'r';
 	}
 
-	if (queenside) {
-		/* queen side castle */
-
-		if ('K' == kingpiece) {
-			pgn_move.from = 4;
-			pgn_move.to = 2;
-
-			pgn_move.castlerookfrom = 0;
-			pgn_move.castlerookto = 3;
-		} else {
-			pgn_move.from = 60;
-			pgn_move.to = 58;
+	Bitboard king = pgn_gameposition.pieces[chess_piece_index(kingpiece)];
+	if (BB_EMPTY == king) {
+		LOG(ERROR, "No king to castle with for move %s", movestr);
+		return;
+	}
+	int from = BB_FIRST(king);
 
-			pgn_move.castlerookfrom = 56;
-			pgn_move.castlerookto = 59;
+	/* the rook with the right on that side, king takes rook is never */
+	/* ambiguous; without a right the king goes two files from e1/e8 */
+	Bitboard rooks = CHESS_CASTLE_ROOKS(pgn_gameposition.castling) & BB_RANK(from >> 3);
+	int to = (from & ~7) + (queenside ? 2 : 6);
+	if (queenside) {
+		rooks &= BB_SQUARE(from) - 1;
+		if (BB_EMPTY != rooks) {
+			to = BB_FIRST(rooks);
 		}
 	} else {
-		/* king side castle */
-		if ('K' == kingpiece) {
-			pgn_move.from = 4;
-			pgn_move.to = 6;
-
-			pgn_move.castlerookfrom = 7;
-			pgn_move.castlerookto = 5;
-		} else {
-			pgn_move.from = 60;
-			pgn_move.to = 62;
-
-			pgn_move.castlerookfrom = 63;
-			pgn_move.castlerookto = 61;
+		rooks &= ~((BB_SQUARE(from) << 1) - 1);
+		if (BB_EMPTY != rooks) {
+			to = BB_LAST(rooks);
 		}
 	}
 
-	pgn_long_notation( pgn_move.from, pgn_move.to, CW_NO_PIECE, pgn_move.long_algebraic );
+	int kingto = 0;
+	if (!chess_is_castling(&pgn_gameposition, kingpiece, from, to,
+			&kingto, &pgn_move.castlerookfrom, &pgn_move.castlerookto)) {
+		LOG(ERROR, "Failed to castle for move %s", movestr);
+		return;
+	}
+
+	pgn_move.from = from;
+	pgn_move.to = kingto;
+
+	pgn_long_notation( pgn_move.from, pgn_gameinfo.chess960 ? pgn_move.castlerookfrom : pgn_move.to,
+			CW_NO_PIECE, pgn_move.long_algebraic );
 
 	LOG(INFO, "Next move: Castle %c %d  -->  %d", pgn_move.piece, pgn_move.from, pgn_move.to);
 
-	pgn_gameposition.board[pgn_move.from] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.to] = pgn_move.piece;
-	pgn_gameposition.board[pgn_move.castlerookfrom] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.castlerookto] = pgn_move.castlerookpiece;
+	pgn_perform_game_move(from, to, CW_NO_PIECE);
 }
 
 static void pgn_update_move_en_passant(int movenum, const char* movestr, char pawnpiece, int from, int to, int enpassantcapturepos)
@@ -416,9 +452,7 @@ static void pgn_update_move_en_passant(int movenum, const char* movestr, char pa
 
 	LOG(INFO, "Next move: %c %d  -->  %d  En passant", pgn_move.piece, pgn_move.from, pgn_move.to);
 
-	pgn_gameposition.board[pgn_move.from] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.to] = pgn_move.piece;
-	pgn_gameposition.board[pgn_move.enpassantcapturepos] = CW_NO_PIECE;
+	pgn_perform_game_move(pgn_move.from, pgn_move.to, CW_NO_PIECE);
 }
 
 static void pgn_update_move_promote(int movenum, const char* movestr, char pawnpiece, int from, int to, char promotepiece)
@@ -439,49 +473,7 @@ static void pgn_update_move_promote(int movenum, const char* movestr, char pawnp
 
 	LOG(INFO, "Next move: %c %d  -->  %d  =  %c", pgn_move.piece, pgn_move.from, pgn_move.to, pgn_move.promotepiece);
 
-	pgn_gameposition.board[pgn_move.from] = CW_NO_PIECE;
-	pgn_gameposition.board[pgn_move.to] = pgn_move.promotepiece;
-}
-
-static int pgn_find_from_pos(Position* pos, int to, char piece, bool capture, int disambiguityfile, int disambiguityrank)
-{
-	int startfile = 0;
-	int endfile = 7;
-	if (0 <= disambiguityfile) {
-		startfile = disambiguityfile;
-		endfile = disambiguityfile;
-	}
-
-	int startrank = 0;
-	int endrank = 7;
-	if (0 <= disambiguityrank) {
-		startrank = disambiguityrank;
-		endrank = disambiguityrank;
-	}
-
-	for (int r = startrank; r <= endrank; ++r) {
-		for (int f = startfile; f <= endfile; ++f) {
-			int from = (CW_NB_OF_FILES * r) + f;
-			char boardpiece = pos->board[from];
-			if (piece == boardpiece) {
-				if (chess_is_possible_move(pos->board, from, to, piece, capture)) {
-					/* the move is not possible if under check */
-					/* we have to perform the move */
-					Position tmppos;
-					memcpy(&tmppos, pos, sizeof(Position));
-					pgn_perform_move( piece, from, to, CW_NO_PIECE, &tmppos );
-
-					char kingpiece = isupper(piece) ? 'K' : 'k';
-					if (!chess_is_in_check(tmppos.board, kingpiece)) {
-						return from;
-					}
-				}
-			}
-		}
-	}
-
-	/* no success */
-	return -1;
+	pgn_perform_game_move(pgn_move.from, pgn_move.to, pgn_move.promotepiece);
 }
 
 static void pgn_parse_move(int movenum, const char* pgn)
@@ -541,7 +533,6 @@ static void pgn_parse_move(int movenum, const char* pgn)
 	/* get rid of special case; castle */
 	if (1 < castlecnt) {
 		pgn_update_move_castle(movenum, pgn, pgn_piece_for_color_to_move('K'), 2 < castlecnt);
-		pgn_next_color();
 		return;
 	}
 
@@ -591,7 +582,7 @@ static void pgn_parse_move(int movenum, const char* pgn)
 	}
 
 	/* search for from pos */
-	int from = pgn_find_from_pos(&pgn_gameposition, to, piece, 0 <= captureidx, disambiguityfile, disambiguityrank);
+	int from = chess_find_from_square(&pgn_gameposition, to, piece, 0 <= captureidx, disambiguityfile, disambiguityrank);
 
 	if (0 > from) {
 		LOG(ERROR, "Failed to find from position for move %s", pgn);
@@ -600,7 +591,7 @@ static void pgn_parse_move(int movenum, const char* pgn)
 
 	if (CW_NO_PIECE != promotepiece) {
 		pgn_update_move_promote(movenum, pgn, piece, from, to, promotepiece);
-	} else if (chess_is_en_passant_capture(pgn_gameposition.board, piece, from, to)) {
+	} else if (chess_is_en_passant_capture(&pgn_gameposition, piece, from, to)) {
 		if ('P' == piece) {
 			pgn_update_move_en_passant(movenum, pgn, piece, from, to, to - 8);
 		} else {
@@ -611,7 +602,6 @@ static void pgn_parse_move(int movenum, const char* pgn)
 	} else {
 		pgn_update_move_normal(movenum, pgn, piece, from, to);
 	}
-	pgn_next_color();
 }
 
 static void pgn_parse_result(const char* resultstr)
@@ -631,21 +621,15 @@ static void pgn_parse_result(const char* resultstr)
 	}
 }
 
-static void pgn_next_color()
-{
-	if (WHITE == pgn_nextmovecolor) {
-		pgn_nextmovecolor = BLACK;
-	} else {
-		pgn_nextmovecolor = WHITE;
-	}
-}
-
 static void pgn_fen_to_position(const char* fen, Position* p)
 {
 	dbgutil_test(NULL != fen);
 	dbgutil_test(NULL != p);
 
 	memset(p, 0, sizeof(Position));
+	p->tomove = WHITE;
+	p->enpassant = CHESS_NO_SQUARE;
+	p->fullmove = 1;
 
 	/* FEN starts from upper left of board (at a8, that is) */
 	int rank = 7;
@@ -666,30 +650,142 @@ static void pgn_fen_to_position(const char* fen, Position* p)
 
 		++fen;
 	}
+
+	/* color to move */
+	fen = pgn_fen_next_field(fen);
+	if ('b' == *fen) {
+		p->tomove = BLACK;
+	}
+
+	/* castling rights */
+	fen = pgn_fen_next_field(fen);
+	while (*fen && ' ' != *fen) {
+		p->castling |= pgn_fen_castling_right(p, *fen);
+		++fen;
+	}
+
+	/* en passant square */
+	fen = pgn_fen_next_field(fen);
+	if ('a' <= fen[0] && 'h' >= fen[0] && '1' <= fen[1] && '8' >= fen[1]) {
+		p->enpassant = (fen[0] - 'a') + (CW_NB_OF_FILES * (fen[1] - '1'));
+	}
+
+	/* half move clock and full move number, not always present */
+	fen = pgn_fen_next_field(fen);
+	if (isdigit(*fen)) {
+		p->halfmove = atoi(fen);
+	}
+
+	fen = pgn_fen_next_field(fen);
+	if (isdigit(*fen) && atoi(fen) > 0) {
+		p->fullmove = atoi(fen);
+	}
+
+	chess_setup_position(p);
 }
 
-static bool pgn_get_color_from_fen(const char* fen, Color* color)
+static const char* pgn_fen_next_field(const char* fen)
 {
-	dbgutil_test(NULL != fen);
-	dbgutil_test(NULL != color);
-
-	/* color to move after first space */
-	char* cpos = strchr(fen, ' ');
-	if ( NULL == cpos) {
-		return false;
+	/* skip rest of current field and the spaces after it */
+	while (*fen && ' ' != *fen) {
+		++fen;
+	}
+	while (' ' == *fen) {
+		++fen;
 	}
 
-	++cpos;
+	return fen;
+}
+
+static int pgn_fen_castling_right(const Position* pos, char ch)
+{
+	/* KQkq is the outermost rook on that side of the king (X-FEN), */
+	/* a file letter names the rook (Shredder-FEN), both for Chess960 */
+	bool white = isupper(ch) != 0;
+	int base = white ? 0 : 56;
+	char rook = white ? 'R' : 'r';
+	char king = white ? 'K' : 'k';
+
+	int kingfile = 4;
+	for (int f = 0; f < CW_NB_OF_FILES; ++f) {
+		if (king == pos->board[base + f]) {
+			kingfile = f;
+		}
+	}
 
-	if ('w' == *cpos) {
-		*color = WHITE;
-	} else if ('b' == *cpos) {
-		*color = BLACK;
+	int file = -1;
+	ch = toupper(ch);
+	if ('K' == ch) {
+		file = 7;
+		for (int f = 7; f > kingfile; --f) {
+			if (rook == pos->board[base + f]) {
+				file = f;
+				break;
+			}
+		}
+	} else if ('Q' == ch) {
+		file = 0;
+		for (int f = 0; f < kingfile; ++f) {
+			if (rook == pos->board[base + f]) {
+				file = f;
+				break;
+			}
+		}
+	} else if ('A' <= ch && 'H' >= ch) {
+		file = ch - 'A';
 	} else {
-		return false;
+		return 0;
 	}
 
-	return true;
+	return white ? CHESS_CASTLE_WHITE(file) : CHESS_CASTLE_BLACK(file);
+}
+
+static char* pgn_fen_castling(const Position* pos, Color color, char* wp)
+{
+	int rank = (WHITE == color) ? 0 : 7;
+	Bitboard rights = CHESS_CASTLE_ROOKS(pos->castling) & BB_RANK(rank);
+	Bitboard rooks = pos->pieces[chess_piece_index((WHITE == color) ? 'R' : 'r')] & BB_RANK(rank);
+	Bitboard king = pos->pieces[chess_piece_index((WHITE == color) ? 'K' : 'k')] & BB_RANK(rank);
+	int kingsq = (BB_EMPTY != king) ? BB_FIRST(king) : (rank * 8) + 4;
+	char kingside = (WHITE == color) ? 'K' : 'k';
+	char queenside = (WHITE == color) ? 'Q' : 'q';
+	char filea = (WHITE == color) ? 'A' : 'a';
+
+	/* king side first as in KQkq, X-FEN: the file only when another */
+	/* rook stands further out on that side */
+	Bitboard above = ~((BB_SQUARE(kingsq) << 1) - 1);
+	Bitboard side = rights & above;
+	while (BB_EMPTY != side) {
+		int sq = BB_LAST(side);
+		side &= ~BB_SQUARE(sq);
+		bool outermost = BB_EMPTY == (rooks & ~((BB_SQUARE(sq) << 1) - 1));
+		*wp++ = outermost ? kingside : filea + (sq & 7);
+	}
+
+	side = rights & ~above & ~BB_SQUARE(kingsq);
+	while (BB_EMPTY != side) {
+		int sq = bb_pop_first(&side);
+		bool outermost = BB_EMPTY == (rooks & (BB_SQUARE(sq) - 1));
+		*wp++ = outermost ? queenside : filea + (sq & 7);
+	}
+
+	return wp;
+}
+
+static bool pgn_is_chess960_start(const Position* pos)
+{
+	/* standard rights only ever name the corners, with the king on e1/e8 */
+	Bitboard rooks = CHESS_CASTLE_ROOKS(pos->castling);
+	Bitboard corners = BB_SQUARE(0) | BB_SQUARE(7) | BB_SQUARE(56) | BB_SQUARE(63);
+	if (BB_EMPTY != (rooks & ~corners)) {
+		return true;
+	}
+
+	if ((pos->castling & CHESS_CASTLE_WHITE_ALL) && 'K' != pos->board[4]) {
+		return true;
+	}
+
+	return (pos->castling & CHESS_CASTLE_BLACK_ALL) && 'k' != pos->board[60];
 }
 
 static char* pgn_game_info_alloc_and_save_str(char* ptr, const char* str)
@@ -712,8 +808,6 @@ static void pgn_game_info_save_str(char* ptr, const char* str, size_t maxlen)
 	ptr[maxlen] = '\0';
 }
 
-#define PGN_SAFE_FREE( p ) if ( NULL != p ) { free( p ); p = NULL; }
-
 static void pgn_free_game_info(GameInfo* info)
 {
 	PGN_SAFE_FREE(info->white);
@@ -741,93 +835,115 @@ static void pgn_long_notation( int from, int to, char promotepiece, char* long_a
 	}
 }
 
-static void pgn_perform_move( char piece, int from, int to,
-		char promotepiece, Position* pos )
+static int pgn_square( const char* str )
 {
-	if (chess_is_en_passant_capture(pos->board, piece, from, to)) {
-		if ('p' == piece) {
-			pos->board[to + 8] = CW_NO_PIECE;
-		} else {
-			pos->board[to - 8] = CW_NO_PIECE;
-		}
-	}
-
-	int rookfrom = 0;
-	int rookto = 0;
-	if ( chess_is_castling( pos->board, piece, from, to,
-			&rookfrom, &rookto) ) {
-		pos->board[ rookto ] = pos->board[ rookfrom ];
-		pos->board[ rookfrom ] = CW_NO_PIECE;
+	if ( str[ 0 ] < 'a' || str[ 0 ] > 'h' || str[ 1 ] < '1' || str[ 1 ] > '8' ) {
+		return CHESS_NO_SQUARE;
 	}
 
-	pos->board[from] = CW_NO_PIECE;
-	if ( promotepiece != CW_NO_PIECE ) {
-		pos->board[to] = promotepiece;
-	} else {
-		pos->board[to] = piece;
-	}
+	return ( str[ 0 ] - 'a' ) + ( ( str[ 1 ] - '1' ) * 8 );
 }
 
-static bool pgn_disambiguity_marker( char piece, int from, int to, Position* pos, char* marker )
+static bool pgn_is_line_move( const Position* pos, int from, int to, char promotepiece )
 {
-	if ( tolower( piece ) == 'k' || tolower( piece ) == 'p' ) {
+	/* all but leaving the own king in check, that is up to the caller */
+	char piece = pos->board[ from ];
+	if ( piece == CW_NO_PIECE || ( isupper( piece ) != 0 ) != ( pos->tomove == WHITE ) ) {
 		return false;
 	}
 
-	bool capture = pos->board[ to ] != CW_NO_PIECE;
-	char my_king = isupper( piece ) ? 'K' : 'k';
+	if ( chess_is_castling( pos, piece, from, to, NULL, NULL, NULL ) ) {
+		/* Chess960 engines send king takes own rook */
+		return promotepiece == CW_NO_PIECE &&
+			chess_is_possible_move( pos, from, to, piece, false );
+	}
 
-	int possible_sources[ CW_NB_OF_SQUARES ];
-	int cnt = 0;
+	char target = pos->board[ to ];
+	if ( target != CW_NO_PIECE && ( isupper( target ) != 0 ) == ( pos->tomove == WHITE ) ) {
+		return false;
+	}
 
-	for ( int i = 0; i < CW_NB_OF_SQUARES; ++i ) {
+	bool capture = target != CW_NO_PIECE ||
+		chess_is_en_passant_capture( pos, piece, from, to );
+	if ( !chess_is_possible_move( pos, from, to, piece, capture ) ) {
+		return false;
+	}
 
-		if ( pos->board[ i ] == piece ) {
+	bool promotion = ( piece == 'P' || piece == 'p' ) && ( to < 8 || to >= 56 );
+	if ( promotion ) {
+		return promotepiece != CW_NO_PIECE && strchr( "QRBNqrbn", promotepiece ) != NULL;
+	}
 
-			if ( chess_is_possible_move( pos->board, i, to, piece, capture ) ) {
+	return promotepiece == CW_NO_PIECE;
+}
 
-				Position pos_copy;
-				memcpy( &pos_copy, pos, sizeof(Position) );
+static char* pgn_san( const Position* pos, int from, int to, char promotepiece, char* wp )
+{
+	char piece = pos->board[ from ];
+	bool capture = pos->board[ to ] != CW_NO_PIECE;
 
-				pgn_perform_move( piece, i, to, CW_NO_PIECE, &pos_copy );
+	int rookfrom = 0;
+	if ( chess_is_castling( pos, piece, from, to, NULL, &rookfrom, NULL ) ) {
+		strcpy( wp, ( rookfrom < from ) ? "O-O-O" : "O-O" );
+		return wp + strlen( wp );
+	}
 
-				if ( !chess_is_in_check( pos_copy.board, my_king ) ) {
-					/* possible */
-					possible_sources[ cnt ] = i;
-					cnt++;
-				}
-			}
+	if ( piece == 'P' || piece == 'p' ) {
+		if ( ( from & 7 ) != ( to & 7 ) ) {
+			/* capture, en passant included */
+			*wp++ = 'a' + ( from & 7 );
+			*wp++ = 'x';
 		}
+		*wp++ = 'a' + ( to & 7 );
+		*wp++ = '1' + ( to >> 3 );
+		if ( promotepiece != CW_NO_PIECE ) {
+			*wp++ = '=';
+			*wp++ = toupper( promotepiece );
+		}
+		return wp;
 	}
 
-	bool conflict_file = false;
-	bool conflict_rank = false;
-	for ( int i = 0; i < cnt; ++i ) {
-		int f = (possible_sources[ i ] & 7);
-		int r = (possible_sources[ i ] >> 3);
-		for ( int j = i + 1; j < cnt; ++j ) {
-			int fn = (possible_sources[ j ] & 7);
-			if ( f == fn ) {
-				conflict_file = true;
-			}
-			int rn = (possible_sources[ j ] >> 3);
-			if ( r == rn ) {
-				conflict_rank = true;
-			}
+	*wp++ = toupper( piece );
+
+	/* other pieces of the same kind that can legally go there */
+	Bitboard others = chess_legal_sources( pos, to, piece, capture ) & ~BB_SQUARE( from );
+	bool samefile = ( others & BB_FILE( from & 7 ) ) != BB_EMPTY;
+	bool samerank = ( others & BB_RANK( from >> 3 ) ) != BB_EMPTY;
+
+	if ( others != BB_EMPTY ) {
+		if ( !samefile ) {
+			*wp++ = 'a' + ( from & 7 );
+		} else if ( !samerank ) {
+			*wp++ = '1' + ( from >> 3 );
+		} else {
+			*wp++ = 'a' + ( from & 7 );
+			*wp++ = '1' + ( from >> 3 );
 		}
 	}
 
-	if ( cnt > 1 ) {
-		if ( conflict_file && conflict_rank ) {
-			sprintf( marker, "%c%c", 'a' + ( from & 7 ), '1' + ( from >> 3 ) );
-		} else if ( conflict_file ) {
-			sprintf( marker, "%c", '1' + ( from >> 3 ) );
-		} else {
-			sprintf( marker, "%c", 'a' + ( from & 7 ) );
+	if ( capture ) {
+		*wp++ = 'x';
+	}
+	*wp++ = 'a' + ( to & 7 );
+	*wp++ = '1' + ( to >> 3 );
+
+	return wp;
+}
+
+static bool pgn_is_line_repetition( const Position* pos, int behind, const uint64_t* linehashes, int plies )
+{
+	/* pos is the position after move number plies (from 0) of the line */
+	if ( pgn_history_repetitions( pos, behind, plies + 1 ) > 0 ) {
+		return true;
+	}
+
+	for ( int i = plies - 2; i >= 0 && (plies - i) <= pos->halfmove; i -= 2 ) {
+		if ( linehashes[ i ] == pos->hash ) {
+			return true;
 		}
 	}
 
-	return (cnt > 1);
+	return false;
 }
 
 static bool pgn_init_next_game()
@@ -843,7 +959,58 @@ static bool pgn_init_next_game()
 	}
 
 	pgn_fen_to_position(fen, &pgn_gameposition);
-	pgn_get_color_from_fen(fen, &pgn_nextmovecolor);
+
+	pgn_gameinfo.chess960 = pgn_gameinfo.chess960 || pgn_is_chess960_start(&pgn_gameposition);
+
+	pgn_history_cnt = 0;
+	pgn_history_push(pgn_gameposition.hash);
 
 	return true;
 }
+
+static void pgn_perform_game_move( int from, int to, char promotepiece )
+{
+	chess_perform_move( &pgn_gameposition, from, to, promotepiece );
+
+	pgn_history_push( pgn_gameposition.hash );
+}
+
+/* pos is plies half moves ahead of the game position behind half moves */
+/* before the current one, only history up to that position counts */
+static int pgn_history_repetitions( const Position* pos, int behind, int plies )
+{
+	int cnt = 0;
+	int last = pgn_history_cnt - 1 - behind;
+
+	/* the history entry back steps behind that position is plies + back */
+	/* half moves before pos; only those with the same side to move and after */
+	/* the last capture or pawn move can be equal, so the clock bounds the scan */
+	int back = (plies & 1) ? 1 : 0;
+	if ( plies + back == 0 ) {
+		back = 2;
+	}
+
+	for ( ; plies + back <= pos->halfmove && back <= last; back += 2 ) {
+		if ( pgn_history[ last - back ] == pos->hash ) {
+			cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+static void pgn_history_push( uint64_t hash )
+{
+	if ( pgn_history_cnt >= pgn_history_size ) {
+		uint64_t* history = realloc( pgn_history,
+				(pgn_history_size + PGN_HISTORY_ALLOC_SIZE) * sizeof(uint64_t) );
+		if ( history == NULL ) {
+			return;
+		}
+		pgn_history = history;
+		pgn_history_size += PGN_HISTORY_ALLOC_SIZE;
+	}
+
+	pgn_history[ pgn_history_cnt ] = hash;
+	pgn_history_cnt++;
+}
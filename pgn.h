@@ -2,13 +2,10 @@
 #define __pgn_h__
 
 #include "defs.h"
+#include "chess.h"
 
 #include <stdbool.h>
-
-typedef struct
-{
-	char board[CW_NB_OF_SQUARES];
-} Position;
+#include <stddef.h>
 
 typedef enum
 {
@@ -76,6 +73,11 @@ typedef struct
 	char eco[PGN_MAX_LEN_ECO];
 	char* fen;
 	GameResultType result;
+
+	/* Variant tag says Chess960, or castling rights in the start position */
+	/* are held by a king or rook off the standard squares; long algebraic */
+	/* castling moves are king takes rook then, as UCI_Chess960 wants */
+	bool chess960;
 } GameInfo;
 
 bool pgn_init(const char* filename);
@@ -87,16 +89,35 @@ bool pgn_next_random_game();
 const Position* pgn_position();
 const Move* pgn_next_move();
 
-typedef enum
-{
-	WHITE,
-	BLACK
-} Color;
 Color pgn_next_to_move();
 
 const GameInfo* pgn_game_info();
 
-bool pgn_long_algebraic_to_pgn( char* long_algebraic, char* pgn, Position* pos );
-bool pgn_long_algebraic_perform_move( char* long_algebraic, Position* pos );
+typedef enum
+{
+	DRAW_NONE,
+	DRAW_REPETITION,
+	DRAW_FIFTY_MOVES
+} DrawRuleType;
+
+/* draw rule that applies to the current game position */
+DrawRuleType pgn_draw_rule();
+
+/* number of times pos occurred earlier in the game, pos is plies half moves */
+/* ahead of the current game position (0 for the game position itself) */
+int pgn_position_repetitions( const Position* pos, int plies );
+
+/* convert an engine line of long algebraic moves played from pos to SAN */
+/* with move numbers, written to line (size chars); stops at an illegal */
+/* move, at a repetition or when line is full, returns the plies written; */
+/* pos is the game position behind half moves before the current one */
+int pgn_line_to_san( const Position* pos, int behind, const char* moves, char* line, size_t size );
+
+/* SAN of a single legal move from pos, without move number or check */
+/* marks; san must hold at least CW_MAX_MOVE_STRING chars */
+void pgn_move_to_san( const Position* pos, int from, int to, char promotepiece, char* san );
+
+/* fen must hold at least CW_MAX_FEN_STRING chars */
+void pgn_position_to_fen( const Position* pos, char* fen );
 
 #endif /* __pgn_h__ */
@@ -52,7 +52,10 @@ size_t pgnparser_readpos = 0;
 size_t pgnparser_fposlastread = 0;
 size_t pgnparser_fposgame = 0;
 
+/* can be overridden at build time, the tests keep their state out of the way */
+#ifndef PGN_PARSER_FILE_NAME_STATE
 #define PGN_PARSER_FILE_NAME_STATE "/tmp/.chessviewerscreensaver"
+#endif
 
 /****************************************************/
 
@@ -97,6 +100,12 @@ void pgn_parser_close()
 		fclose(pgnparser_file);
 		pgnparser_file = NULL;
 	}
+
+	/* nothing buffered from this file may leak into the next one */
+	pgnparser_bufcnt = 0;
+	pgnparser_readpos = 0;
+	pgnparser_fposlastread = 0;
+	pgnparser_fposgame = 0;
 }
 
 void pgn_parser_next_game()
@@ -422,10 +431,15 @@ static bool pgn_parser_load_state( const char* fname )
 {
 	FILE* fp = fopen( fname, "r" );
 	if ( NULL != fp ) {
-		fread( &pgnparser_fposgame, sizeof(pgnparser_fposgame), 1, fp );
+		size_t cnt = fread( &pgnparser_fposgame, sizeof(pgnparser_fposgame), 1, fp );
 		fclose( fp );
 		fp = NULL;
 
+		if ( 1 != cnt ) {
+			pgnparser_fposgame = 0;
+			return false;
+		}
+
 		LOG(INFO, "Loaded game position: %u", pgnparser_fposgame);
 
 		return true;
@@ -30,6 +30,10 @@ bool popen2(const char *cmdline, struct popen2 *childinfo)
 		perror("execl");
 		exit(99);
 	}
+	/* only the child keeps these, or a dead engine never reads as end of file */
+	close(pipe_stdin[0]);
+	close(pipe_stdout[1]);
+
 	childinfo->child_pid = p;
 	childinfo->to_child = pipe_stdin[1];
 	childinfo->from_child = pipe_stdout[0];
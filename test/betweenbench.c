@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "chesstables.h"
+#include "defs.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* blocked tests for every pair of squares on a common line, over random */
+/* boards: the chess_between lookup chess.c uses against the square */
+/* stepping loop it replaced, which is kept here as the reference; both */
+/* have to give the same answers */
+
+/****************************************************/
+
+#define BETWEEN_BENCH_BOARDS 64
+#define BETWEEN_BENCH_ROUNDS 200
+
+#define CHESS_FILE( p ) (p & 7)
+#define CHESS_RANK( p ) (p >> 3)
+
+/****************************************************/
+
+static char between_bench_boards[ BETWEEN_BENCH_BOARDS ][ CW_NB_OF_SQUARES ];
+static Bitboard between_bench_occupied[ BETWEEN_BENCH_BOARDS ];
+
+static int between_bench_from[ CW_NB_OF_SQUARES * CW_NB_OF_SQUARES ];
+static int between_bench_to[ CW_NB_OF_SQUARES * CW_NB_OF_SQUARES ];
+static int between_bench_nb_of_pairs = 0;
+
+/****************************************************/
+
+static bool between_bench_loop_blocked( const char* board, int from, int to );
+static void between_bench_setup();
+static double between_bench_seconds( const struct timespec* start );
+
+/****************************************************/
+
+int main()
+{
+	between_bench_setup();
+
+	long tests = 0;
+	long loopblocked = 0;
+	long tableblocked = 0;
+
+	struct timespec start;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( int r = 0; r < BETWEEN_BENCH_ROUNDS; ++r ) {
+		for ( int b = 0; b < BETWEEN_BENCH_BOARDS; ++b ) {
+			for ( int i = 0; i < between_bench_nb_of_pairs; ++i ) {
+				loopblocked += between_bench_loop_blocked( between_bench_boards[ b ],
+					between_bench_from[ i ], between_bench_to[ i ] );
+				tests++;
+			}
+		}
+	}
+
+	double loops = between_bench_seconds( &start );
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( int r = 0; r < BETWEEN_BENCH_ROUNDS; ++r ) {
+		for ( int b = 0; b < BETWEEN_BENCH_BOARDS; ++b ) {
+			for ( int i = 0; i < between_bench_nb_of_pairs; ++i ) {
+				/* as chess_is_move_blocked() */
+				tableblocked += BB_EMPTY != ( chess_between[ between_bench_from[ i ] ][ between_bench_to[ i ] ] &
+					between_bench_occupied[ b ] );
+			}
+		}
+	}
+
+	double tables = between_bench_seconds( &start );
+
+	bool same = loopblocked == tableblocked;
+
+	printf( "%ld blocked tests, %ld blocked, answers %s\n", tests, loopblocked,
+		same ? "agree" : "DIFFER" );
+	printf( "square stepping loop: %.2f ns/test\n", loops * 1e9 / tests );
+	printf( "between table:        %.2f ns/test\n", tables * 1e9 / tests );
+
+	return same ? 0 : 1;
+}
+
+/****************************************************/
+
+/* chess_is_move_blocked() before the between table */
+static bool between_bench_loop_blocked( const char* board, int from, int to )
+{
+	int xdiff = CHESS_FILE( to ) - CHESS_FILE(from);
+	int xdir = xdiff != 0 ? (xdiff / abs(xdiff)) : 0;
+
+	int ydiff = CHESS_RANK( to ) - CHESS_RANK(from);
+	int ydir = ydiff != 0 ? (ydiff / abs(ydiff)) : 0;
+
+	int x = CHESS_FILE(from);
+	int y = CHESS_RANK(from);
+
+	x += xdir;
+	y += ydir;
+
+	while (((y * 8) + x) != to) {
+		if (CW_NO_PIECE != board[((y * 8) + x)]) {
+			return true;
+		}
+
+		x += xdir;
+		y += ydir;
+	}
+
+	return false;
+}
+
+/* a third of the squares taken, the same boards every run */
+static void between_bench_setup()
+{
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+	for ( int b = 0; b < BETWEEN_BENCH_BOARDS; ++b ) {
+		for ( int sq = 0; sq < CW_NB_OF_SQUARES; ++sq ) {
+			/* xorshift64 */
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+
+			between_bench_boards[ b ][ sq ] = ( 0 == seed % 3 ) ? 'P' : CW_NO_PIECE;
+			if ( CW_NO_PIECE != between_bench_boards[ b ][ sq ] ) {
+				between_bench_occupied[ b ] |= BB_SQUARE( sq );
+			}
+		}
+	}
+
+	for ( int from = 0; from < CW_NB_OF_SQUARES; ++from ) {
+		for ( int to = 0; to < CW_NB_OF_SQUARES; ++to ) {
+			if ( from != to && BB_EMPTY != chess_line[ from ][ to ] ) {
+				between_bench_from[ between_bench_nb_of_pairs ] = from;
+				between_bench_to[ between_bench_nb_of_pairs ] = to;
+				between_bench_nb_of_pairs++;
+			}
+		}
+	}
+}
+
+static double between_bench_seconds( const struct timespec* start )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec ) + ( now.tv_nsec - start->tv_nsec ) / 1e9;
+}
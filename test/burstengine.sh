@@ -0,0 +1,36 @@
+#!/bin/sh
+# UCI engine stand-in for test/enginetest.c: answers a go with
+# $1 info lines and the bestmove, all in one write; with "deaf" as $2
+# quit is ignored
+
+lines=${1:-400}
+mode=${2:-}
+
+burst=$(mktemp)
+trap 'rm -f "$burst"' EXIT
+
+i=1
+while [ $i -le $lines ]; do
+	echo "info depth $i score cp $i pv e2e4"
+	i=$((i + 1))
+done > "$burst"
+echo "bestmove e2e4" >> "$burst"
+
+while read -r cmd rest; do
+	case "$cmd" in
+	uci)
+		echo "id name Burst"
+		echo "uciok"
+		;;
+	isready)
+		echo "readyok"
+		;;
+	go)
+		# cat writes the file with a single write()
+		cat "$burst"
+		;;
+	quit)
+		[ "$mode" = deaf ] || exit 0
+		;;
+	esac
+done
@@ -0,0 +1,447 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pgn.h"
+#include "chess.h"
+#include "chesspack.h"
+#include "book.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* replays test/chess.pgn through the pgn move decoder and compares every */
+/* final position with test/chess.fen (one line per game), every position */
+/* on the way also goes through chesspack and back; then checks move */
+/* generation with perft counts for the positions in test/perft.pgn and */
+/* Polyglot keys and book lookups */
+
+/****************************************************/
+
+#define CHESS_TEST_DECODE_ROUNDS 2000
+
+/* expected leaf counts for the games in perft.pgn, in order */
+static const struct
+{
+	int depth;
+	long nodes;
+} chess_test_perft[] =
+{
+	{ 5, 4865609 },
+	{ 4, 4085603 },
+	{ 5, 674624 },
+	{ 4, 422333 },
+	{ 4, 2103487 },
+	{ 4, 326672 },
+	{ 4, 667366 }
+};
+
+#define CHESS_TEST_NB_OF_PERFT ( sizeof( chess_test_perft ) / sizeof( chess_test_perft[ 0 ] ) )
+
+/* reference keys of the Polyglot book format, moves from the start */
+static const struct
+{
+	const char* moves;
+	uint64_t key;
+} chess_test_polyglot[] =
+{
+	{ "", 0x463b96181691fc9cull },
+	{ "e2e4", 0x823c9b50fd114196ull },
+	{ "e2e4 d7d5", 0x0756b94461c50fb0ull },
+	{ "e2e4 d7d5 e4e5", 0x662fafb965db29d4ull },
+	{ "e2e4 d7d5 e4e5 f7f5", 0x22a48b5a8e47ff78ull },
+	{ "e2e4 d7d5 e4e5 f7f5 e1e2", 0x652a607ca3f242c1ull },
+	{ "e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00fdd303c946bdd9ull },
+	{ "a2a4 b7b5 h2h4 b5b4 c2c4", 0x3c8123ea7b067637ull },
+	{ "a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5c3f9b829b279560ull }
+};
+
+#define CHESS_TEST_NB_OF_POLYGLOT ( sizeof( chess_test_polyglot ) / sizeof( chess_test_polyglot[ 0 ] ) )
+
+/****************************************************/
+
+static int chess_test_replay( const char* pgnfile, const char* fenfile );
+static int chess_test_perft_all( const char* pgnfile );
+static bool chess_test_pack( const Position* pos );
+static bool chess_test_pack_overfull();
+static bool chess_test_book_keys();
+static bool chess_test_book_probe();
+static void chess_test_start_position( Position* pos, const char* moves );
+static unsigned chess_test_book_move( const char* move );
+static void chess_test_decode_speed( const char* pgnfile, int nbofgames );
+static long chess_test_perft_count( const Position* pos, int depth );
+static double chess_test_seconds( const struct timespec* start );
+
+/****************************************************/
+
+int main( int argc, char* argv[] )
+{
+	if ( 4 != argc ) {
+		fprintf( stderr, "usage: %s <games.pgn> <final.fen> <perft.pgn>\n", argv[ 0 ] );
+		return 2;
+	}
+
+	int failures = 0;
+
+	int nbofgames = chess_test_replay( argv[ 1 ], argv[ 2 ] );
+	if ( 0 > nbofgames ) {
+		failures++;
+	} else {
+		chess_test_decode_speed( argv[ 1 ], nbofgames );
+	}
+
+	if ( !chess_test_pack_overfull() ) {
+		failures++;
+	}
+
+	if ( !chess_test_book_keys() ) {
+		failures++;
+	}
+
+	if ( !chess_test_book_probe() ) {
+		failures++;
+	}
+
+	failures += chess_test_perft_all( argv[ 3 ] );
+
+	printf( "%s\n", 0 == failures ? "OK" : "FAILED" );
+
+	return 0 == failures ? 0 : 1;
+}
+
+/****************************************************/
+
+/* returns the number of games replayed, or -1 if any final position differs */
+static int chess_test_replay( const char* pgnfile, const char* fenfile )
+{
+	FILE* fp = fopen( fenfile, "r" );
+	if ( NULL == fp ) {
+		fprintf( stderr, "can't open %s\n", fenfile );
+		return -1;
+	}
+
+	if ( !pgn_init( pgnfile ) ) {
+		fprintf( stderr, "can't open %s\n", pgnfile );
+		fclose( fp );
+		return -1;
+	}
+
+	int game = 0;
+	bool ok = true;
+	char expected[ CW_MAX_FEN_STRING + 2 ];
+	char fen[ CW_MAX_FEN_STRING ];
+
+	/* pgn wraps around at end of file, the fen file decides the game count */
+	while ( NULL != fgets( expected, sizeof( expected ), fp ) ) {
+		expected[ strcspn( expected, "\r\n" ) ] = '\0';
+		if ( '\0' == expected[ 0 ] ) {
+			continue;
+		}
+
+		game++;
+		if ( !pgn_next_game() ) {
+			printf( "game %d: no game in %s\n", game, pgnfile );
+			ok = false;
+			break;
+		}
+
+		int plies = 0;
+		bool packed = chess_test_pack( pgn_position() );
+		while ( NULL != pgn_next_move() ) {
+			plies++;
+			packed = chess_test_pack( pgn_position() ) && packed;
+		}
+
+		pgn_position_to_fen( pgn_position(), fen );
+
+		const char* event = pgn_game_info()->event;
+		if ( !packed ) {
+			printf( "game %d (%s): FAILED, position differs after pack and unpack\n",
+				game, NULL != event ? event : "?" );
+			ok = false;
+		} else if ( 0 != strcmp( fen, expected ) ) {
+			printf( "game %d (%s): FAILED after %d plies\n  got      %s\n  expected %s\n",
+				game, NULL != event ? event : "?", plies, fen, expected );
+			ok = false;
+		} else {
+			printf( "game %d (%s): ok, %d plies\n", game, NULL != event ? event : "?", plies );
+		}
+	}
+
+	pgn_close();
+	fclose( fp );
+
+	return ok ? game : -1;
+}
+
+static void chess_test_decode_speed( const char* pgnfile, int nbofgames )
+{
+	if ( 0 >= nbofgames || !pgn_init( pgnfile ) ) {
+		return;
+	}
+
+	long moves = 0;
+	struct timespec start;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( int i = 0; i < CHESS_TEST_DECODE_ROUNDS * nbofgames; ++i ) {
+		pgn_next_game();
+		while ( NULL != pgn_next_move() ) {
+			moves++;
+		}
+	}
+
+	double s = chess_test_seconds( &start );
+	printf( "decoded %ld moves in %.3f s: %.0f moves/s\n", moves, s, s > 0.0 ? moves / s : 0.0 );
+
+	pgn_close();
+}
+
+/* unpacked again the position has to be the same, derived parts included */
+static bool chess_test_pack( const Position* pos )
+{
+	PackedPosition packed;
+	if ( !chesspack_pack( pos, &packed ) ) {
+		return false;
+	}
+
+	Position unpacked;
+	chesspack_unpack( &packed, &unpacked );
+
+	return 0 == memcmp( pos->board, unpacked.board, sizeof( pos->board ) )
+		&& 0 == memcmp( pos->pieces, unpacked.pieces, sizeof( pos->pieces ) )
+		&& 0 == memcmp( pos->occupied, unpacked.occupied, sizeof( pos->occupied ) )
+		&& pos->tomove == unpacked.tomove
+		&& pos->castling == unpacked.castling
+		&& pos->enpassant == unpacked.enpassant
+		&& pos->halfmove == unpacked.halfmove
+		&& pos->fullmove == unpacked.fullmove
+		&& pos->hash == unpacked.hash
+		&& 0 == memcmp( pos->attacks, unpacked.attacks, sizeof( pos->attacks ) )
+		&& 0 == memcmp( pos->checkers, unpacked.checkers, sizeof( pos->checkers ) )
+		&& 0 == memcmp( pos->pinned, unpacked.pinned, sizeof( pos->pinned ) );
+}
+
+/* a board with 33 pieces has to be refused, not packed */
+static bool chess_test_pack_overfull()
+{
+	Position pos;
+	chess_test_start_position( &pos, "" );
+	pos.board[ 20 ] = 'P';
+	chess_setup_position( &pos );
+
+	PackedPosition packed;
+	bool ok = !chesspack_pack( &pos, &packed );
+
+	printf( "pack 33 pieces: %s\n", ok ? "refused, ok" : "FAILED, packed" );
+
+	return ok;
+}
+
+static bool chess_test_book_keys()
+{
+	bool ok = true;
+
+	for ( int i = 0; i < CHESS_TEST_NB_OF_POLYGLOT; ++i ) {
+		Position pos;
+		chess_test_start_position( &pos, chess_test_polyglot[ i ].moves );
+
+		uint64_t key = book_key( &pos );
+		if ( key != chess_test_polyglot[ i ].key ) {
+			printf( "polyglot key after \"%s\": FAILED, %016llx, expected %016llx\n",
+				chess_test_polyglot[ i ].moves, (unsigned long long) key,
+				(unsigned long long) chess_test_polyglot[ i ].key );
+			ok = false;
+		}
+	}
+
+	printf( "polyglot keys: %s\n", ok ? "ok" : "FAILED" );
+
+	return ok;
+}
+
+/* writes a small book and looks up positions in and out of it */
+static bool chess_test_book_probe()
+{
+	Position start;
+	Position italian;
+	Position e4;
+	chess_test_start_position( &start, "" );
+	chess_test_start_position( &italian, "e2e4 e7e5 g1f3 b8c6 f1c4 f8c5" );
+	chess_test_start_position( &e4, "e2e4" );
+
+	uint64_t key = book_key( &start );
+
+	/* weight 0, an illegal move and a second d2d4 with less weight */
+	/* are left out, castling is king takes rook */
+	struct ChessTestBookEntry
+	{
+		uint64_t key;
+		const char* move;
+		unsigned weight;
+	} entries[] =
+	{
+		{ key - 1, "a2a3", 1 },
+		{ key, "e2e4", 30 },
+		{ key, "g1f3", 0 },
+		{ key, "d2d4", 10 },
+		{ key, "e2e5", 20 },
+		{ key, "d2d4", 5 },
+		{ key + 1, "h2h3", 1 },
+		{ book_key( &italian ), "e1h1", 7 }
+	};
+	int nbofentries = sizeof( entries ) / sizeof( entries[ 0 ] );
+
+	/* a book is sorted by key */
+	for ( int i = 1; i < nbofentries; ++i ) {
+		struct ChessTestBookEntry entry = entries[ i ];
+		int j = i;
+		for ( ; j > 0 && entries[ j - 1 ].key > entry.key; --j ) {
+			entries[ j ] = entries[ j - 1 ];
+		}
+		entries[ j ] = entry;
+	}
+
+	char filename[] = "/tmp/chesstest-book-XXXXXX";
+	int fd = mkstemp( filename );
+	if ( fd < 0 ) {
+		printf( "book: FAILED, can't create %s\n", filename );
+		return false;
+	}
+
+	FILE* fp = fdopen( fd, "wb" );
+	for ( int i = 0; i < nbofentries; ++i ) {
+		unsigned char entry[ 16 ] = { 0 };
+		unsigned move = chess_test_book_move( entries[ i ].move );
+		for ( int b = 0; b < 8; ++b ) {
+			entry[ b ] = (unsigned char) ( entries[ i ].key >> ( 56 - 8 * b ) );
+		}
+		entry[ 8 ] = (unsigned char) ( move >> 8 );
+		entry[ 9 ] = (unsigned char) move;
+		entry[ 10 ] = (unsigned char) ( entries[ i ].weight >> 8 );
+		entry[ 11 ] = (unsigned char) entries[ i ].weight;
+		fwrite( entry, sizeof( entry ), 1, fp );
+	}
+	fclose( fp );
+
+	bool ok = book_open( filename );
+	unlink( filename );
+
+	BookMove moves[ CHESS_MAX_MOVES ];
+
+	int n = ok ? book_moves( &start, moves ) : 0;
+	ok = ok && 2 == n &&
+		chess_test_book_move( "e2e4" ) == (unsigned) ( moves[ 0 ].move.to | moves[ 0 ].move.from << 6 ) &&
+		30 == moves[ 0 ].weight &&
+		chess_test_book_move( "d2d4" ) == (unsigned) ( moves[ 1 ].move.to | moves[ 1 ].move.from << 6 ) &&
+		10 == moves[ 1 ].weight;
+
+	/* castling as chess_legal_moves() has it, the king two files over */
+	n = ok ? book_moves( &italian, moves ) : 0;
+	ok = ok && 1 == n && 4 == moves[ 0 ].move.from && 6 == moves[ 0 ].move.to &&
+		7 == moves[ 0 ].weight;
+
+	ok = ok && 0 == book_moves( &e4, moves );
+
+	book_close();
+
+	printf( "book: %s\n", ok ? "ok" : "FAILED" );
+
+	return ok;
+}
+
+/* start position with the moves, long algebraic and space separated, made */
+static void chess_test_start_position( Position* pos, const char* moves )
+{
+	memset( pos, 0, sizeof( Position ) );
+	memcpy( pos->board, "RNBQKBNRPPPPPPPP", 16 );
+	memcpy( pos->board + 48, "pppppppprnbqkbnr", 16 );
+	pos->tomove = WHITE;
+	pos->castling = CHESS_CASTLE_WHITE_KINGSIDE | CHESS_CASTLE_WHITE_QUEENSIDE |
+		CHESS_CASTLE_BLACK_KINGSIDE | CHESS_CASTLE_BLACK_QUEENSIDE;
+	pos->enpassant = CHESS_NO_SQUARE;
+	pos->fullmove = 1;
+	chess_setup_position( pos );
+
+	for ( const char* m = moves; '\0' != *m; m += ( ' ' == m[ 4 ] ) ? 5 : 4 ) {
+		unsigned move = chess_test_book_move( m );
+		chess_perform_move( pos, ( move >> 6 ) & 0x3f, move & 0x3f, CW_NO_PIECE );
+	}
+}
+
+/* Polyglot move of a long algebraic move without promotion */
+static unsigned chess_test_book_move( const char* move )
+{
+	unsigned from = ( move[ 0 ] - 'a' ) + 8 * ( move[ 1 ] - '1' );
+	unsigned to = ( move[ 2 ] - 'a' ) + 8 * ( move[ 3 ] - '1' );
+
+	return to | from << 6;
+}
+
+/* returns the number of failed perft positions */
+static int chess_test_perft_all( const char* pgnfile )
+{
+	if ( !pgn_init( pgnfile ) ) {
+		fprintf( stderr, "can't open %s\n", pgnfile );
+		return 1;
+	}
+
+	int failures = 0;
+
+	for ( int i = 0; i < CHESS_TEST_NB_OF_PERFT; ++i ) {
+		if ( !pgn_next_game() ) {
+			printf( "perft %d: no game in %s\n", i + 1, pgnfile );
+			failures++;
+			break;
+		}
+
+		struct timespec start;
+		clock_gettime( CLOCK_MONOTONIC, &start );
+
+		long nodes = chess_test_perft_count( pgn_position(), chess_test_perft[ i ].depth );
+
+		double s = chess_test_seconds( &start );
+		const char* event = pgn_game_info()->event;
+		bool ok = nodes == chess_test_perft[ i ].nodes;
+
+		printf( "perft %d (%s) depth %d: %ld nodes, %s, %.0f nodes/s\n",
+			i + 1, NULL != event ? event : "?", chess_test_perft[ i ].depth, nodes,
+			ok ? "ok" : "FAILED", s > 0.0 ? nodes / s : 0.0 );
+		if ( !ok ) {
+			printf( "  expected %ld nodes\n", chess_test_perft[ i ].nodes );
+			failures++;
+		}
+	}
+
+	pgn_close();
+
+	return failures;
+}
+
+static long chess_test_perft_count( const Position* pos, int depth )
+{
+	ChessMove moves[ CHESS_MAX_MOVES ];
+	int nbofmoves = chess_legal_moves( pos, moves );
+
+	if ( 1 >= depth ) {
+		return nbofmoves;
+	}
+
+	long nodes = 0;
+	for ( int i = 0; i < nbofmoves; ++i ) {
+		Position next = *pos;
+		chess_perform_move( &next, moves[ i ].from, moves[ i ].to, moves[ i ].promotepiece );
+		nodes += chess_test_perft_count( &next, depth - 1 );
+	}
+
+	return nodes;
+}
+
+static double chess_test_seconds( const struct timespec* start )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec ) + ( now.tv_nsec - start->tv_nsec ) / 1e9;
+}
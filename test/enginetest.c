@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "engine.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+/* runs test/burstengine.sh through the engine module: a search whose */
+/* info lines and bestmove arrive in one burst, more lines than the engine */
+/* thread handles per wakeup, must end with the last depth delivered; */
+/* options set for one engine must not stay in the settings key of the */
+/* next, and an engine that ignores quit must not hang engine_close() */
+
+/****************************************************/
+
+#define ENGINE_TEST_LINES 400
+#define ENGINE_TEST_TIMEOUT_MS 5000
+
+/****************************************************/
+
+static int engine_test_depth = 0;
+
+/****************************************************/
+
+static int engine_test_burst( int round );
+static int engine_test_settings_key( const char* cmd );
+static int engine_test_deaf( const char* script );
+static void engine_test_callback( const EngineSnapshot* snapshot, void* user_data );
+static double engine_test_ms( const struct timespec* start );
+
+/****************************************************/
+
+int main( int argc, char* argv[] )
+{
+	if ( 2 != argc ) {
+		fprintf( stderr, "usage: %s <burstengine.sh>\n", argv[ 0 ] );
+		return 2;
+	}
+
+	/* an engine that went away must fail the test, not kill it */
+	(void) signal( SIGPIPE, SIG_IGN );
+
+	char cmd[ 256 ];
+	snprintf( cmd, sizeof( cmd ), "%s %d", argv[ 1 ], ENGINE_TEST_LINES );
+	if ( 1 != engine_init( cmd, 1 ) ) {
+		fprintf( stderr, "can't start %s\n", cmd );
+		return 1;
+	}
+
+	int failures = 0;
+
+	engine_new_game( 0, NULL );
+
+	/* a bestmove left behind by the first search would end the second */
+	for ( int round = 0; round < 2; ++round ) {
+		failures += engine_test_burst( round );
+	}
+
+	failures += engine_test_settings_key( cmd );
+	failures += engine_test_deaf( argv[ 1 ] );
+
+	printf( "%s\n", 0 == failures ? "OK" : "FAILED" );
+
+	return 0 == failures ? 0 : 1;
+}
+
+/****************************************************/
+
+static int engine_test_burst( int round )
+{
+	struct timespec start;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	engine_test_depth = 0;
+
+	unsigned done = engine_done_count();
+	engine_go( 0, -1, engine_test_callback, NULL );
+
+	while ( !engine_is_done( 0 ) && engine_test_ms( &start ) < ENGINE_TEST_TIMEOUT_MS ) {
+		engine_wait_done( done, 100 );
+	}
+
+	if ( !engine_is_done( 0 ) ) {
+		printf( "burst %d: no bestmove after %d ms\n", round, ENGINE_TEST_TIMEOUT_MS );
+		engine_stop( 0 );
+		return 1;
+	}
+
+	if ( ENGINE_TEST_LINES != engine_test_depth ) {
+		printf( "burst %d: last depth %d, expected %d\n", round, engine_test_depth, ENGINE_TEST_LINES );
+		return 1;
+	}
+
+	printf( "burst %d: %d lines in %.1f ms\n", round, ENGINE_TEST_LINES, engine_test_ms( &start ) );
+	return 0;
+}
+
+/* closes the running engine */
+static int engine_test_settings_key( const char* cmd )
+{
+	uint64_t key = engine_settings_key();
+	engine_set_option( "Contempt", "10" );
+	bool changed = engine_settings_key() != key;
+
+	engine_close();
+	if ( 1 != engine_init( cmd, 1 ) ) {
+		printf( "settings key: can't restart %s\n", cmd );
+		return 1;
+	}
+	bool reset = engine_settings_key() == key;
+	engine_close();
+
+	printf( "settings key: %s\n", changed && reset ? "ok" : "FAILED" );
+	return changed && reset ? 0 : 1;
+}
+
+static int engine_test_deaf( const char* script )
+{
+	char cmd[ 256 ];
+	snprintf( cmd, sizeof( cmd ), "%s 1 deaf", script );
+	if ( 1 != engine_init( cmd, 1 ) ) {
+		printf( "deaf engine: can't start %s\n", cmd );
+		return 1;
+	}
+
+	struct timespec start;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	/* a hanging engine_close() ends the test here */
+	alarm( ENGINE_TEST_TIMEOUT_MS / 1000 );
+	engine_close();
+	alarm( 0 );
+
+	printf( "deaf engine: closed in %.1f ms\n", engine_test_ms( &start ) );
+	return 0;
+}
+
+/* engine thread */
+static void engine_test_callback( const EngineSnapshot* snapshot, void* user_data )
+{
+	engine_test_depth = snapshot->depth;
+}
+
+static double engine_test_ms( const struct timespec* start )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec ) * 1000.0 + ( now.tv_nsec - start->tv_nsec ) / 1000000.0;
+}
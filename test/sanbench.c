@@ -0,0 +1,100 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pgn.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* decodes every game of a pgn file, rounds times, and reports SAN moves */
+/* per second; only pgn_next_move() is timed, the tag sections are not */
+
+/****************************************************/
+
+#define SAN_BENCH_ROUNDS_DEFAULT 1
+
+/****************************************************/
+
+static int san_bench_count_games( const char* pgnfile );
+static double san_bench_seconds( const struct timespec* start );
+
+/****************************************************/
+
+int main( int argc, char* argv[] )
+{
+	if ( 2 != argc && 3 != argc ) {
+		fprintf( stderr, "usage: %s <games.pgn> [rounds]\n", argv[ 0 ] );
+		return 2;
+	}
+
+	int rounds = ( 3 == argc ) ? atoi( argv[ 2 ] ) : SAN_BENCH_ROUNDS_DEFAULT;
+
+	/* pgn wraps around at end of file, the games are counted first */
+	int nbofgames = san_bench_count_games( argv[ 1 ] );
+	if ( 0 >= nbofgames || 0 >= rounds || !pgn_init( argv[ 1 ] ) ) {
+		fprintf( stderr, "no games in %s\n", argv[ 1 ] );
+		return 1;
+	}
+
+	long moves = 0;
+	double s = 0.0;
+
+	for ( int i = 0; i < rounds * nbofgames; ++i ) {
+		if ( !pgn_next_game() ) {
+			break;
+		}
+
+		struct timespec start;
+		clock_gettime( CLOCK_MONOTONIC, &start );
+
+		while ( NULL != pgn_next_move() ) {
+			moves++;
+		}
+
+		s += san_bench_seconds( &start );
+	}
+
+	pgn_close();
+
+	printf( "%d games, %d rounds: %ld SAN moves in %.3f s, %.0f SAN moves/s\n",
+		nbofgames, rounds, moves, s, s > 0.0 ? moves / s : 0.0 );
+
+	return 0;
+}
+
+/****************************************************/
+
+/* one Event tag per game */
+static int san_bench_count_games( const char* pgnfile )
+{
+	FILE* fp = fopen( pgnfile, "r" );
+	if ( NULL == fp ) {
+		return -1;
+	}
+
+	int nbofgames = 0;
+	char line[ 256 ];
+	bool linestart = true;
+
+	while ( NULL != fgets( line, sizeof( line ), fp ) ) {
+		if ( linestart && 0 == strncmp( line, "[Event ", 7 ) ) {
+			nbofgames++;
+		}
+		/* a line longer than the buffer comes in pieces */
+		linestart = ( NULL != strchr( line, '\n' ) );
+	}
+
+	fclose( fp );
+
+	return nbofgames;
+}
+
+static double san_bench_seconds( const struct timespec* start )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec ) + ( now.tv_nsec - start->tv_nsec ) / 1e9;
+}
@@ -3,6 +3,8 @@
 #include "movelist.h"
 #include "log.h"
 #include "dbgutil.h"
+#include "defs.h"
+#include "bitboard.h"
 
 
 #ifndef __USE_BSD
@@ -80,8 +82,13 @@ int ui_screenheight = -1;
 int ui_infoendposy = 0;
 int ui_infofontchwidth = 0;
 int ui_evalposy = 0;
+int ui_nbofevallines = 1;
+int ui_ecoposy = 0;
 int ui_board_pos_x = 0;
 
+/* squares the last move arrow was drawn over */
+Bitboard ui_arrowsquares = BB_EMPTY;
+
 /*******************************************************/
 
 static void ui_board_pos_to_pixel(int pos, int* x, int* y);
@@ -103,6 +110,8 @@ static void ui_draw_name_tag_value(const char* tag, const char* value,
 		int x, int y, int maxwidth, int* width);
 static void ui_draw_game_info_player(const char* tag, const char* value,
 		const char* elostr, int x, int y, int maxwidth);
+static void ui_draw_game_info_eco(const char* eco, const char* ecoinfo,
+		int x, int y, int maxwidth);
 static void ui_draw_full_move_str(int x, int y, int maxwidth, int movenum,
 		const char* whitepgn, const char* blackpgn);
 static int ui_info_font_normal_char_width();
@@ -111,6 +120,9 @@ static void ui_rotate(XPoint* points, int npoints, int rx, int ry,
 		double angle);
 static void ui_draw_arrowhead(int xfrom, int yfrom, int xto, int yto);
 static void ui_draw_coordinates();
+static void ui_draw_rank_coordinate(int y);
+static void ui_draw_file_coordinate(int x);
+static void ui_draw_square(int pos);
 
 /*******************************************************/
 
@@ -451,28 +463,18 @@ void ui_draw_game_info(const char* white, const char* black,
 		y += UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO;
 	}
 
+	/* the line is kept also without an ECO tag, the opening may be */
+	/* classified from the moves later, see ui_draw_opening() */
+	ui_ecoposy = y;
 	if (NULL != eco && 0 < strlen(eco)) {
-
-		int	ecowidth = 0;
-		ui_draw_game_info_tag_value("ECO:", eco, x, y, maxwidth, &ecowidth);
-
-		if ( NULL != ecoinfo ) {
-			int ecoinfowidth1 = 0;
-			ui_draw_info_string( " (", x + ecowidth, y, maxwidth - ecowidth, &ecoinfowidth1 );
-			int ecoinfowidth2 = 0;
-			ui_draw_info_string( ecoinfo, x + ecowidth + ecoinfowidth1, y,
-					maxwidth - ecowidth - ecoinfowidth1 - UI_SPACING_X_INFO, &ecoinfowidth2 );
-			ui_draw_info_string( ")", x + ecowidth + ecoinfowidth1 + ecoinfowidth2, y,
-					maxwidth - ecowidth - ecoinfowidth1 - ecoinfowidth2, NULL );
-		}
-
-		y += UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO;
+		ui_draw_game_info_eco(eco, ecoinfo, x, y, maxwidth);
 	}
+	y += UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO;
 
 	/* update engine eval. start pos */
 	ui_evalposy = y;
 
-	y += UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO;
+	y += ui_nbofevallines * (UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO);
 
 	/* update movelist start pos */
 	ui_infoendposy = y;
@@ -504,6 +506,8 @@ void ui_draw_board()
 
 	/* coordinates */
 	ui_draw_coordinates();
+
+	ui_arrowsquares = BB_EMPTY;
 }
 
 void ui_draw_piece(char piece, int pos)
@@ -528,8 +532,36 @@ void ui_draw_piece(char piece, int pos)
 	XftDrawString16(ui_xftdraw, color, ui_piecefont, x, y, &piecechar, 1);
 }
 
+void ui_draw_squares(const char* board, uint64_t squares)
+{
+	dbgutil_test(NULL != board);
+
+	/* the arrow of the last move goes away with them */
+	squares |= ui_arrowsquares;
+	ui_arrowsquares = BB_EMPTY;
+
+	while (BB_EMPTY != squares) {
+		int pos = bb_pop_first(&squares);
+		ui_draw_square(pos);
+		if (CW_NO_PIECE != board[pos]) {
+			ui_draw_piece(board[pos], pos);
+		}
+	}
+}
+
 void ui_highlight_move(int from, int to)
 {
+	/* the arrow and its head stay within the rectangle of squares */
+	/* spanned by from and to */
+	int minfile = (from % 8) < (to % 8) ? (from % 8) : (to % 8);
+	int maxfile = (from % 8) < (to % 8) ? (to % 8) : (from % 8);
+	int minrank = (from / 8) < (to / 8) ? (from / 8) : (to / 8);
+	int maxrank = (from / 8) < (to / 8) ? (to / 8) : (from / 8);
+	for (int rank = minrank; rank <= maxrank; ++rank) {
+		for (int file = minfile; file <= maxfile; ++file) {
+			ui_arrowsquares |= BB_SQUARE(8 * rank + file);
+		}
+	}
 
 	(void) XSetForeground(ui_display, ui_gcontext, UI_COL_HIGHLIGHT_SQUARE);
 	(void) XSetLineAttributes(ui_display, ui_gcontext, UI_SIZE_HIGHLIGHT_LINE_WIDTH,
@@ -604,22 +636,57 @@ void ui_draw_move_str(int movenum, bool white, const char* pgnstr)
 	ui_draw_move_list( ui_infoendposy, UI_POS_BOARD_Y + 8 * UI_SIZE_SQUARE_HEIGHT );
 }
 
+void ui_set_nb_of_eval_lines( int n )
+{
+	ui_nbofevallines = ( n > 0 ) ? n : 1;
+}
+
 void ui_draw_engine_eval( const char* scorestr, const char* evalstr )
 {
-	int x = UI_POS_INFO_X;
+	ui_draw_engine_evals( &scorestr, &evalstr, 1 );
+}
+
+void ui_draw_engine_evals( const char* const scorestrs[], const char* const evalstrs[], int n )
+{
 	const int maxwidth = UI_SIZE_INFO_WIDTH;
+	const int lineheight = UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO;
 
 	(void) XSetForeground(ui_display, ui_gcontext, UI_COL_BACKGROUND);
 	XFillRectangle(ui_display, ui_backbuf, ui_gcontext,
-			x, ui_evalposy - UI_FONT_SIZE_INFO - UI_SPACING_Y_INFO / 2,
+			UI_POS_INFO_X, ui_evalposy - UI_FONT_SIZE_INFO - UI_SPACING_Y_INFO / 2,
+			maxwidth, ui_nbofevallines * lineheight);
+
+	for (int i = 0; i < n && i < ui_nbofevallines; ++i) {
+		int x = UI_POS_INFO_X;
+		int y = ui_evalposy + i * lineheight;
+
+		char tag[ 16 ];
+		if ( ui_nbofevallines > 1 ) {
+			snprintf( tag, sizeof(tag), "Eval %d:", i + 1 );
+		} else {
+			snprintf( tag, sizeof(tag), "Eval:" );
+		}
+
+		int pixlen = 0;
+		int accpixlen = 0;
+		ui_draw_game_info_tag_value( tag, scorestrs[ i ], x, y, maxwidth, &pixlen );
+		x += pixlen + ui_infofontchwidth;
+		accpixlen += pixlen + ui_infofontchwidth;
+		ui_draw_info_string( evalstrs[ i ], x, y, maxwidth - accpixlen, &pixlen );
+	}
+}
+
+void ui_draw_opening( const char* eco, const char* ecoinfo )
+{
+	const int x = UI_POS_INFO_X;
+	const int maxwidth = UI_SIZE_INFO_WIDTH;
+
+	(void) XSetForeground(ui_display, ui_gcontext, UI_COL_BACKGROUND);
+	XFillRectangle(ui_display, ui_backbuf, ui_gcontext,
+			x, ui_ecoposy - UI_FONT_SIZE_INFO - UI_SPACING_Y_INFO / 2,
 			maxwidth, UI_FONT_SIZE_INFO + UI_SPACING_Y_INFO);
 
-	int pixlen = 0;
-	int accpixlen = 0;
-	ui_draw_game_info_tag_value( "Eval:", scorestr, x, ui_evalposy, maxwidth, &pixlen );
-	x += pixlen + ui_infofontchwidth;
-	accpixlen += pixlen + ui_infofontchwidth;
-	ui_draw_info_string( evalstr, x, ui_evalposy, maxwidth - accpixlen, &pixlen );
+	ui_draw_game_info_eco( eco, ecoinfo, x, ui_ecoposy, maxwidth );
 }
 
 void ui_draw_result( const char* resultstr )
@@ -843,6 +910,22 @@ static void ui_draw_game_info_player(const char* tag, const char* value, const c
 	}
 }
 
+static void ui_draw_game_info_eco(const char* eco, const char* ecoinfo, int x, int y, int maxwidth)
+{
+	int	ecowidth = 0;
+	ui_draw_game_info_tag_value("ECO:", eco, x, y, maxwidth, &ecowidth);
+
+	if ( NULL != ecoinfo ) {
+		int ecoinfowidth1 = 0;
+		ui_draw_info_string( " (", x + ecowidth, y, maxwidth - ecowidth, &ecoinfowidth1 );
+		int ecoinfowidth2 = 0;
+		ui_draw_info_string( ecoinfo, x + ecowidth + ecoinfowidth1, y,
+				maxwidth - ecowidth - ecoinfowidth1 - UI_SPACING_X_INFO, &ecoinfowidth2 );
+		ui_draw_info_string( ")", x + ecowidth + ecoinfowidth1 + ecoinfowidth2, y,
+				maxwidth - ecowidth - ecoinfowidth1 - ecoinfowidth2, NULL );
+	}
+}
+
 static void ui_draw_full_move_str(int x, int y, int maxwidth, int movenum, const char* whitepgn, const char* blackpgn)
 {
 	int numwidth = 0;
@@ -967,43 +1050,73 @@ static void ui_draw_arrowhead(int xfrom, int yfrom, int xto, int yto)
 static void ui_draw_coordinates()
 {
 	for ( int y = 0; y < 8; ++y ) {
+		ui_draw_rank_coordinate( y );
+	}
 
-		XftChar8 c = '8' - y;
-		XGlyphInfo extents;
-		XftTextExtentsUtf8(ui_display, ui_coordfont, &c, 1, &extents);
+	for ( int x = 0; x < 8; ++x ) {
+		ui_draw_file_coordinate( x );
+	}
+}
 
-		int xPos = ui_board_pos_x + (4 * UI_SIZE_SQUARE_WIDTH) / 100;
-		int yPos = UI_POS_BOARD_Y + (UI_SIZE_SQUARE_HEIGHT * y) +
-				extents.height + (4 * UI_SIZE_SQUARE_WIDTH) / 100;
+static void ui_draw_rank_coordinate(int y)
+{
+	XftChar8 c = '8' - y;
+	XGlyphInfo extents;
+	XftTextExtentsUtf8(ui_display, ui_coordfont, &c, 1, &extents);
 
-		XftColor* color = NULL;
-		if ( y % 2 == 0 ) {
-			color = &ui_squarecolorblack;
-		} else {
-			color = &ui_squarecolorwhite;
-		}
+	int xPos = ui_board_pos_x + (4 * UI_SIZE_SQUARE_WIDTH) / 100;
+	int yPos = UI_POS_BOARD_Y + (UI_SIZE_SQUARE_HEIGHT * y) +
+			extents.height + (4 * UI_SIZE_SQUARE_WIDTH) / 100;
 
-		XftDrawStringUtf8(ui_xftdraw, color, ui_coordfont, xPos, yPos, &c, 1);
+	XftColor* color = NULL;
+	if ( y % 2 == 0 ) {
+		color = &ui_squarecolorblack;
+	} else {
+		color = &ui_squarecolorwhite;
 	}
 
-	for ( int x = 0; x < 8; ++x ) {
+	XftDrawStringUtf8(ui_xftdraw, color, ui_coordfont, xPos, yPos, &c, 1);
+}
 
-		XftChar8 c = 'a' + x;
-		XGlyphInfo extents;
-		XftTextExtentsUtf8(ui_display, ui_coordfont, &c, 1, &extents);
+static void ui_draw_file_coordinate(int x)
+{
+	XftChar8 c = 'a' + x;
+	XGlyphInfo extents;
+	XftTextExtentsUtf8(ui_display, ui_coordfont, &c, 1, &extents);
 
-		int xPos = ui_board_pos_x + (UI_SIZE_SQUARE_WIDTH * (x + 1)) -
-				extents.width;// - (4 * UI_SIZE_SQUARE_WIDTH) / 100;
-		int yPos = UI_POS_BOARD_Y + (UI_SIZE_SQUARE_HEIGHT * 8) -
-				(60 * extents.height) / 100;
+	int xPos = ui_board_pos_x + (UI_SIZE_SQUARE_WIDTH * (x + 1)) -
+			extents.width;// - (4 * UI_SIZE_SQUARE_WIDTH) / 100;
+	int yPos = UI_POS_BOARD_Y + (UI_SIZE_SQUARE_HEIGHT * 8) -
+			(60 * extents.height) / 100;
 
-		XftColor* color = NULL;
-		if ( x % 2 == 0 ) {
-			color = &ui_squarecolorwhite;
-		} else {
-			color = &ui_squarecolorblack;
-		}
+	XftColor* color = NULL;
+	if ( x % 2 == 0 ) {
+		color = &ui_squarecolorwhite;
+	} else {
+		color = &ui_squarecolorblack;
+	}
+
+	XftDrawStringUtf8(ui_xftdraw, color, ui_coordfont, xPos, yPos, &c, 1);
+}
 
-		XftDrawStringUtf8(ui_xftdraw, color, ui_coordfont, xPos, yPos, &c, 1);
+static void ui_draw_square(int pos)
+{
+	int x = 0;
+	int y = 0;
+	ui_board_pos_to_pixel(pos, &x, &y);
+
+	/* a1 is a black square */
+	bool white = ((pos % 8) + (pos / 8)) % 2 != 0;
+	(void) XSetForeground(ui_display, ui_gcontext,
+			white ? UI_COL_WHITE_SQUARE : UI_COL_BLACK_SQUARE);
+	XFillRectangle(ui_display, ui_backbuf, ui_gcontext,
+			x, y, UI_SIZE_SQUARE_WIDTH, UI_SIZE_SQUARE_HEIGHT);
+
+	/* coordinates are drawn on the a file and the first rank */
+	if (0 == pos % 8) {
+		ui_draw_rank_coordinate(7 - (pos / 8));
+	}
+	if (0 == pos / 8) {
+		ui_draw_file_coordinate(pos % 8);
 	}
 }
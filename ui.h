@@ -2,6 +2,7 @@
 #define __ui_h__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 bool ui_init();
 void ui_close();
@@ -26,12 +27,26 @@ void ui_draw_game_info(const char* white,
 void ui_draw_board();
 void ui_draw_piece(char piece, int pos);
 
+/* redraw only the given squares (bit 0 = a1) with their pieces from */
+/* board, together with the squares under the last move arrow */
+void ui_draw_squares(const char* board, uint64_t squares);
+
 void ui_highlight_move(int from, int to);
 
 void ui_draw_move_str(int movenum, bool white, const char* pgnstr);
 
+/* redraw the ECO line of the game info, for an opening classified */
+/* from the moves */
+void ui_draw_opening( const char* eco, const char* ecoinfo );
+
+/* rows kept for engine lines below the game info, from the next game on */
+void ui_set_nb_of_eval_lines( int n );
+
 void ui_draw_engine_eval( const char* scorestr, const char* evalstr );
 
+/* n lines, best first, in one go; the rows left over are cleared */
+void ui_draw_engine_evals( const char* const scorestrs[], const char* const evalstrs[], int n );
+
 void ui_draw_result( const char* resultstr );
 
 